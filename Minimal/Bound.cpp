@@ -3,37 +3,20 @@
 /****************************/
 
 #include "Bound.h"
+#include <math.h>
 
 Bound::Bound()
 {
 	collision = false;
 	toWorld = glm::mat4(1.0f);
 
-	// Create array object and buffers. Remember to delete your buffers when the object is destroyed!
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
+	init_buffers();
+	calc_extent();
 
-	// Consider the VAO as a container for all your buffers.
-	glBindVertexArray(VAO);
-	// Now bind a VBO to it as a GL_ARRAY_BUFFER. 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// glBufferData populates most recently bound buffer with data starting at the 3rd argument and ending after the 2nd argument number of vertices
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	// Enable the usage of layout location 0
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0); 
-	// In what order should it draw those vertices? That's why we'll need a GL_ELEMENT_ARRAY_BUFFER for this.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-	// Unbind the currently bound buffer so that we don't accidentally make unwanted changes to it.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	// Unbind the VAO now so we don't accidentally tamper with it.
-	// NOTE: You must NEVER unbind the element array buffer associated with a VAO!
-	glBindVertexArray(0);
-
-	// Fill axis lists
+	// Fill the world space box. The sweep starts from the first update after construction
 	update();
+	updated = false;
+	has_previous = false;
 }
 
 Bound::Bound(float x, float y, float z)
@@ -47,192 +30,293 @@ Bound::Bound(float x, float y, float z)
 		vertices[i][2] *= z;
 	}
 
+	init_buffers();
+	calc_extent();
+
+	// Fill the world space box. The sweep starts from the first update after construction
+	update();
+	updated = false;
+	has_previous = false;
+}
+
+Bound::~Bound()
+{
+#ifndef DEDICATED_SERVER
+	// Delete previously generated buffers. Note that forgetting to do this can waste GPU memory in a 
+	// large project! This could crash the graphics driver due to memory leaks, or slow down application performance!
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	glState().deletedVertexArray(VAO);
+	glState().deletedBuffer(VBO);
+	glState().deletedBuffer(EBO);
+#endif
+}
+
+void Bound::init_buffers()
+{
+#ifndef DEDICATED_SERVER
 	// Create array object and buffers. Remember to delete your buffers when the object is destroyed!
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 	// Bind the Vertex Array Object (VAO) first, then bind the associated buffers to it.
-	glBindVertexArray(VAO);
+	glState().bindVertexArray(VAO);
 	// Now bind a VBO to it as a GL_ARRAY_BUFFER.
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
 	// glBufferData populates the most recently bound buffer with data starting at the 3rd argument and ending after the 2nd argument number of indices.
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	// Enable the usage of layout location 0 (check the vertex shader to see what this is)
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,  3 * sizeof(GLfloat), (GLvoid*)0);
 	// In what order should it draw those vertices? That's why we'll need a GL_ELEMENT_ARRAY_BUFFER for this.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 	// Unbind the currently bound buffer so that we don't accidentally make unwanted changes to it.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glState().bindBuffer(GL_ARRAY_BUFFER, 0);
 	// Unbind the VAO now so we don't accidentally tamper with it.
 	// NOTE: You must NEVER unbind the element array buffer associated with a VAO!
-	glBindVertexArray(0);
-
-	// Fill axis lists
-	update();
-}
-
-Bound::~Bound()
-{
-	// Delete previously generated buffers. Note that forgetting to do this can waste GPU memory in a 
-	// large project! This could crash the graphics driver due to memory leaks, or slow down application performance!
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	glState().bindVertexArray(0);
+#endif
 }
 
-void Bound::draw(GLuint shaderProgram, glm::mat4 P, glm::mat4 V)
-{
-	// Calculate the combination of the model and view (camera inverse) matrices
-	glm::mat4 modelview = V * toWorld;
-	// We need to calculate this because modern OpenGL does not keep track of any matrix other than the viewport (D)
-	// Consequently, we need to forward the projection, view, and model matrices to the shader programs
-	// Get the location of the uniform variables "projection" and "modelview"
-	uProjection = glGetUniformLocation(shaderProgram, "projection");
-	uModelview = glGetUniformLocation(shaderProgram, "modelview");
-	uCollision = glGetUniformLocation(shaderProgram, "collision_color");
-	// Now send these values to the shader program
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &P[0][0]);
-	glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
+#ifndef DEDICATED_SERVER
+void Bound::draw(const RenderContext & context) {
+	const Shader & shader = *context.shader;
+	// The projection and view come from the Frame block, only the model matrix is per box
+	shader.setMat4(UNIFORM_MODEL, context.transforms.top() * toWorld);
 
 	if (collision == true) {
-		glUniform3f(uCollision, 1.0f, 0.0f, 0.0f);
+		shader.setVec3(UNIFORM_COLLISION_COLOR, 1.0f, 0.0f, 0.0f);
 	}
 	else {
-		glUniform3f(uCollision, 0.0f, 1.0f, 0.0f);
-	}
-
-	// Now draw the cube. We simply need to bind the VAO associated with it.
-	glBindVertexArray(VAO);
-	// Tell OpenGL to draw with triangles, using 36 indices, the type of the indices, and the offset to start from
-	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-	// Unbind the VAO when we're done so we don't accidentally draw extra stuff or tamper with its bound buffers
-	glBindVertexArray(0);
-}
-
-void Bound::draw(GLuint shaderProgram, glm::mat4 P, glm::mat4 V, glm::mat4 C) {
-	// Calculate the combination of the model and view (camera inverse) matrices
-	glm::mat4 modelview = V * C * toWorld;
-	// We need to calculate this because modern OpenGL does not keep track of any matrix other than the viewport (D)
-	// Consequently, we need to forward the projection, view, and model matrices to the shader programs
-	// Get the location of the uniform variables "projection" and "modelview"
-	uProjection = glGetUniformLocation(shaderProgram, "projection");
-	uModelview = glGetUniformLocation(shaderProgram, "modelview");
-	uCollision = glGetUniformLocation(shaderProgram, "collision_color");
-	// Now send these values to the shader program
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &P[0][0]);
-	glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
+		shader.setVec3(UNIFORM_COLLISION_COLOR, 0.0f, 1.0f, 0.0f);
+	}
 
-	if (collision == true) {
-		glUniform3f(uCollision, 1.0f, 0.0f, 0.0f);
+	// Now draw the cube. We simply need to bind the VAO associated with it (skipped when it still is from the last box).
+	glState().bindVertexArray(VAO);
+	// Tell OpenGL to draw with triangles, using 36 indices, the type of the indices, and the offset to start from (once per eye with single-pass stereo)
+	glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, stereoInstances(1));
+}
+#endif
+
+bool obbOverlap(const OBB & a, const OBB & b) {
+	// Small bias on the rotation terms so near-parallel edges do not produce a bogus cross product axis
+	const float epsilon = 1e-6f;
+
+	// b's axes expressed in a's frame, and the offset between the centers in a's frame
+	float R[3][3];
+	float absR[3][3];
+	float t[3];
+	float d[3] = { b.center[0] - a.center[0], b.center[1] - a.center[1], b.center[2] - a.center[2] };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			R[i][j] = a.axis[i][0] * b.axis[j][0] + a.axis[i][1] * b.axis[j][1] + a.axis[i][2] * b.axis[j][2];
+			absR[i][j] = fabsf(R[i][j]) + epsilon;
+		}
+		t[i] = d[0] * a.axis[i][0] + d[1] * a.axis[i][1] + d[2] * a.axis[i][2];
 	}
-	else {
-		glUniform3f(uCollision, 0.0f, 1.0f, 0.0f);
+
+	bool separated = false;
+
+	// a's face normals
+	for (int i = 0; i < 3; i++) {
+		float rb = b.extent[0] * absR[i][0] + b.extent[1] * absR[i][1] + b.extent[2] * absR[i][2];
+		separated |= fabsf(t[i]) > a.extent[i] + rb;
 	}
 
-	// Now draw the cube. We simply need to bind the VAO associated with it.
-	glBindVertexArray(VAO);
-	// Tell OpenGL to draw with triangles, using 36 indices, the type of the indices, and the offset to start from
-	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-	// Unbind the VAO when we're done so we don't accidentally draw extra stuff or tamper with its bound buffers
-	glBindVertexArray(0);
-}
+	// b's face normals
+	for (int j = 0; j < 3; j++) {
+		float ra = a.extent[0] * absR[0][j] + a.extent[1] * absR[1][j] + a.extent[2] * absR[2][j];
+		float distance = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+		separated |= fabsf(distance) > ra + b.extent[j];
+	}
 
-bool Bound::check_collision(Bound * other) {
-	std::sort(this->x_list.begin(), this->x_list.end());
-	std::sort(this->y_list.begin(), this->y_list.end());
-	std::sort(this->z_list.begin(), this->z_list.end());
+	// Cross products of a's axis i with b's axis j
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+			float ra = a.extent[i1] * absR[i2][j] + a.extent[i2] * absR[i1][j];
+			float rb = b.extent[j1] * absR[i][j2] + b.extent[j2] * absR[i][j1];
+			float distance = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+			separated |= fabsf(distance) > ra + rb;
+		}
+	}
 
-	std::sort(other->x_list.begin(), other->x_list.end());
-	std::sort(other->y_list.begin(), other->y_list.end());
-	std::sort(other->z_list.begin(), other->z_list.end());
+	return !separated;
+}
 
-	GLfloat source_x_min = x_list[0];
-	GLfloat source_x_max = x_list[7];
-	GLfloat source_y_min = y_list[0];
-	GLfloat source_y_max = y_list[7];
-	GLfloat source_z_min = z_list[0];
-	GLfloat source_z_max = z_list[7];
+// Rotation of an oriented box as a quaternion
+static glm::quat obbRotation(const OBB & box) {
+	glm::mat3 rotation(glm::vec3(box.axis[0][0], box.axis[0][1], box.axis[0][2]),
+		glm::vec3(box.axis[1][0], box.axis[1][1], box.axis[1][2]),
+		glm::vec3(box.axis[2][0], box.axis[2][1], box.axis[2][2]));
+	return glm::quat_cast(rotation);
+}
 
-	GLfloat target_x_min = other->x_list[0];
-	GLfloat target_x_max = other->x_list[7];
-	GLfloat target_y_min = other->y_list[0];
-	GLfloat target_y_max = other->y_list[7];
-	GLfloat target_z_min = other->z_list[0];
-	GLfloat target_z_max = other->z_list[7];
+// Box part way between two others: centers and extents are interpolated linearly, rotations with slerp
+static OBB interpolateOBB(const OBB & from, const OBB & to, const glm::quat & from_rotation, const glm::quat & to_rotation, float t) {
+	OBB box;
+	glm::mat3 rotation = glm::mat3_cast(glm::slerp(from_rotation, to_rotation, t));
+	for (int i = 0; i < 3; i++) {
+		box.center[i] = from.center[i] + (to.center[i] - from.center[i]) * t;
+		box.extent[i] = from.extent[i] + (to.extent[i] - from.extent[i]) * t;
+		box.axis[i][0] = rotation[i][0];
+		box.axis[i][1] = rotation[i][1];
+		box.axis[i][2] = rotation[i][2];
+	}
+	return box;
+}
 
-	bool x_collides = false;
-	bool y_collides = false;
-	bool z_collides = false;
+float Bound::sweepDistance(glm::quat & from_rotation, glm::quat & to_rotation) {
+	if (!has_previous) {
+		return -1.0f;
+	}
+	from_rotation = obbRotation(prev_oriented_box);
+	to_rotation = obbRotation(oriented_box);
 
-	this->collision = false;
-	other->collision = false;
+	// Furthest any point of the box moves: the center's travel plus the arc swept by its far corner
+	const OBB & to = oriented_box;
+	glm::vec3 travel(to.center[0] - prev_oriented_box.center[0], to.center[1] - prev_oriented_box.center[1], to.center[2] - prev_oriented_box.center[2]);
+	float cos_half_angle = fminf(fabsf(glm::dot(from_rotation, to_rotation)), 1.0f);
+	float radius = sqrtf(to.extent[0] * to.extent[0] + to.extent[1] * to.extent[1] + to.extent[2] * to.extent[2]);
+	float distance = glm::length(travel) + 2.0f * acosf(cos_half_angle) * radius;
+	return distance > SWEEP_MAX_DISTANCE ? -1.0f : distance;
+}
 
-	// Check x-axis overlaps
-	if (source_x_min >= target_x_min && source_x_min <= target_x_max
-		|| source_x_max >= target_x_min && source_x_max <= target_x_max) {
-		x_collides = true;
+AABB Bound::sweptBounds() {
+	glm::quat from_rotation, to_rotation;
+	float distance = sweepDistance(from_rotation, to_rotation);
+	if (distance < 0.0f) {
+		return box;
 	}
 
-	// Check y-axis overlaps
-	if (source_y_min >= target_y_min && source_y_min <= target_y_max
-		|| source_y_max >= target_y_min && source_y_max <= target_y_max) {
-		y_collides = true;
+	// The union of the two AABBs, grown by the far corner's arc to cover the rotation bulging out between them
+	AABB swept;
+	glm::vec3 travel(oriented_box.center[0] - prev_oriented_box.center[0], oriented_box.center[1] - prev_oriented_box.center[1],
+		oriented_box.center[2] - prev_oriented_box.center[2]);
+	float bulge = distance - glm::length(travel);
+	for (int axis = 0; axis < 3; axis++) {
+		swept.min[axis] = fminf(prev_box.min[axis], box.min[axis]) - bulge;
+		swept.max[axis] = fmaxf(prev_box.max[axis], box.max[axis]) + bulge;
 	}
+	return swept;
+}
 
-	// Check z-axis overlaps
-	if (source_z_min >= target_z_min && source_z_min <= target_z_max
-		|| source_z_max >= target_z_min && source_z_max <= target_z_max) {
-		z_collides = true;
+bool Bound::sweptOverlap(const AABB & other_box, const OBB & other_oriented_box, float * time_of_impact) {
+	if (time_of_impact) {
+		*time_of_impact = 1.0f;
 	}
 
-	// Checks for collision
-	if (x_collides && y_collides & z_collides) {
-		this->collision = true;
-		other->collision = true;
-		return true;
+	glm::quat from_rotation, to_rotation;
+	float distance = sweepDistance(from_rotation, to_rotation);
+	if (distance < 0.0f) {
+		// No sweep, just where the box is now
+		bool hit = aabbOverlap(box, other_box);
+		return hit && (shape != BOUND_OBB || obbOverlap(oriented_box, other_oriented_box));
 	}
-	else {
-		//this->collision = false;
-		//other->collision = false;
+
+	// Cheap reject before any SAT test
+	if (!aabbOverlap(sweptBounds(), other_box)) {
 		return false;
 	}
+
+	// Nothing can be skipped if each step moves less than the thinnest side of either box
+	const OBB & to = oriented_box;
+	float thinnest = fminf(fminf(to.extent[0], to.extent[1]), to.extent[2])
+		+ fminf(fminf(other_oriented_box.extent[0], other_oriented_box.extent[1]), other_oriented_box.extent[2]);
+	int steps = thinnest > 0.0f ? (int)ceilf(distance / (2.0f * thinnest)) : SWEEP_MAX_STEPS;
+	steps = steps < 1 ? 1 : (steps > SWEEP_MAX_STEPS ? SWEEP_MAX_STEPS : steps);
+
+	// Walk from the start so the first contact found is the earliest
+	for (int step = 0; step <= steps; step++) {
+		float t = (float)step / steps;
+		if (obbOverlap(interpolateOBB(prev_oriented_box, to, from_rotation, to_rotation, t), other_oriented_box)) {
+			if (time_of_impact) {
+				*time_of_impact = t;
+			}
+			return true;
+		}
+	}
+	return false;
 }
 
-void Bound::update()
+bool Bound::check_swept_collision(Bound * other, float * time_of_impact) {
+	glm::quat from_rotation, to_rotation;
+	if (sweepDistance(from_rotation, to_rotation) < 0.0f) {
+		if (time_of_impact) {
+			*time_of_impact = 1.0f;
+		}
+		return check_collision(other);
+	}
+
+	bool hit = sweptOverlap(other->box, other->oriented_box, time_of_impact);
+	this->collision = hit;
+	other->collision = hit;
+	return hit;
+}
+
+bool Bound::check_collision(Bound * other) {
+	// The AABBs contain the oriented boxes, so they reject most pairs before the full test
+	bool hit = aabbOverlap(box, other->box);
+	if (hit && (shape == BOUND_OBB || other->shape == BOUND_OBB)) {
+		hit = obbOverlap(oriented_box, other->oriented_box);
+	}
+	this->collision = hit;
+	other->collision = hit;
+	return hit;
+}
+
+void Bound::calc_extent()
 {
-	// Fill axis lists
-	x_list.clear();
-	y_list.clear();
-	z_list.clear();
-	for (int i = 0; i < 8; i++) {
-		glm::vec4 new_point = glm::vec4(vertices[i][0], vertices[i][1], vertices[i][2], 1.0f);
-		new_point = this->toWorld * new_point;
-		x_list.push_back(new_point[0]);
-		y_list.push_back(new_point[1]);
-		z_list.push_back(new_point[2]);
+	glm::vec3 low(vertices[0][0], vertices[0][1], vertices[0][2]);
+	glm::vec3 high = low;
+	for (int i = 1; i < 8; i++) {
+		glm::vec3 point(vertices[i][0], vertices[i][1], vertices[i][2]);
+		low = glm::min(low, point);
+		high = glm::max(high, point);
 	}
-	std::sort(this->x_list.begin(), this->x_list.end());
-	std::sort(this->y_list.begin(), this->y_list.end());
-	std::sort(this->z_list.begin(), this->z_list.end());
+	local_center = (low + high) * 0.5f;
+	local_extent = (high - low) * 0.5f;
+}
+
+void Bound::update()
+{
+	update(glm::mat4(1.0f));
 }
 
 void Bound::update(glm::mat4 transform_mat) {
-	// Fill axis lists
-	x_list.clear();
-	y_list.clear();
-	z_list.clear();
-	for (int i = 0; i < 8; i++) {
-		glm::vec4 new_point = glm::vec4(vertices[i][0], vertices[i][1], vertices[i][2], 1.0f);
-		new_point =  transform_mat * this->toWorld * new_point;
-		x_list.push_back(new_point[0]);
-		y_list.push_back(new_point[1]);
-		z_list.push_back(new_point[2]);
-	}
-	std::sort(this->x_list.begin(), this->x_list.end());
-	std::sort(this->y_list.begin(), this->y_list.end());
-	std::sort(this->z_list.begin(), this->z_list.end());
+	// Transform the center, then project the rotated half extents onto each world axis.
+	// Same box as the min/max of the eight transformed corners, without visiting them
+	glm::mat4 model = transform_mat * this->toWorld;
+	prev_box = box;
+	prev_oriented_box = oriented_box;
+	has_previous = updated;
+	updated = true;
+
+	glm::vec4 center = model * glm::vec4(local_center, 1.0f);
+	for (int axis = 0; axis < 3; axis++) {
+		float extent = fabsf(model[0][axis]) * local_extent.x
+			+ fabsf(model[1][axis]) * local_extent.y
+			+ fabsf(model[2][axis]) * local_extent.z;
+		box.min[axis] = center[axis] - extent;
+		box.max[axis] = center[axis] + extent;
+	}
+
+	// Oriented box: the model's columns are the axes, scaled by the extents
+	for (int i = 0; i < 3; i++) {
+		glm::vec3 column(model[i]);
+		float scale = glm::length(column);
+		glm::vec3 unit = scale > 0.0f ? column / scale : glm::vec3(i == 0, i == 1, i == 2);
+		oriented_box.center[i] = center[i];
+		oriented_box.axis[i][0] = unit.x;
+		oriented_box.axis[i][1] = unit.y;
+		oriented_box.axis[i][2] = unit.z;
+		oriented_box.extent[i] = local_extent[i] * scale;
+	}
 }
 
 void Bound::spin(float deg)
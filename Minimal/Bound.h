@@ -5,6 +5,7 @@
 #ifndef _BOUND_H_
 #define _BOUND_H_
 
+#ifndef DEDICATED_SERVER
 #define GLFW_INCLUDE_GLEXT
 #ifdef __APPLE__
 #define GLFW_INCLUDE_GLCOREARB
@@ -12,15 +13,60 @@
 #include <GL/glew.h>
 #endif
 #include <GLFW/glfw3.h>
+#include "RenderContext.h"
+#else
+// The dedicated server has no GL context, only the collision math is compiled
+typedef float GLfloat;
+typedef unsigned int GLuint;
+#endif
 // Use of degrees is deprecated. Use radians instead.
 #ifndef GLM_FORCE_RADIANS
 #define GLM_FORCE_RADIANS
 #endif
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <vector>
 #include <algorithm>
 
+// World space axis-aligned box. Plain data, so updating and testing one never touches the heap
+struct AABB {
+	float min[3];
+	float max[3];
+};
+
+// Overlap on all three axes (touching counts). Evaluated with & instead of && so there are no branches
+inline bool aabbOverlap(const AABB & a, const AABB & b) {
+	return (a.min[0] <= b.max[0]) & (b.min[0] <= a.max[0])
+		& (a.min[1] <= b.max[1]) & (b.min[1] <= a.max[1])
+		& (a.min[2] <= b.max[2]) & (b.min[2] <= a.max[2]);
+}
+
+// Oriented box: center, unit axes and the half size along each. Plain data, like AABB
+struct OBB {
+	float center[3];
+	float axis[3][3];		// axis[i] is the i-th unit axis in world space
+	float extent[3];		// Half size along each axis
+};
+
+/* Separating axis test of two oriented boxes (the 3 + 3 face normals and 9 edge cross products)
+ * Every axis is tested and the results are combined, no early outs, so the loops stay straight-line code
+ */
+bool obbOverlap(const OBB & a, const OBB & b);
+
+// Limits of the swept test: the most in-between boxes tested per pair, and the largest motion still treated as
+// a swing (anything further is a reset or a teleport, and only the current box is tested)
+#define SWEEP_MAX_STEPS 32
+#define SWEEP_MAX_DISTANCE 2.0f
+
+// How a bound is tested for collisions. Testing an OBB against anything uses SAT (an AABB is an OBB on the world axes)
+enum BoundShape {
+	// World axis-aligned extents of the rotated box: cheapest, loose once the box rotates
+	BOUND_AABB = 0,
+	// The rotated box itself: for long, thin boxes swung at arbitrary angles (swords)
+	BOUND_OBB = 1,
+};
+
 class Bound
 {
 public:
@@ -29,27 +75,26 @@ public:
 
 	// These variables are needed for the shader program
 	GLuint VBO, VAO, EBO;
-	GLuint uProjection, uModelview, uCollision;
 
 	bool collision = false;
-	std::vector<GLfloat> x_list;
-	std::vector<GLfloat> y_list;
-	std::vector<GLfloat> z_list;
+	BoundShape shape = BOUND_AABB;	// Collision test used by check_collision
+	AABB box;						// World space bounds from the last update
+	OBB oriented_box;				// Oriented bounds from the last update
+	AABB prev_box;					// World space bounds from the update before
+	OBB prev_oriented_box;			// Oriented bounds from the update before, the start of the sweep
+	bool has_previous = false;		// prev_box and prev_oriented_box are valid
 
 	/* Functions */
 	Bound();
 	Bound(float x, float y, float z);
 	~Bound();
 
-	void draw(GLuint shaderProg, glm::mat4 P, glm::mat4 V);	// LEGACY CODE, MAY NOT WORK ON THIS CODE
-
-	/* Render functions that takes into account a passed in transform C
-	 * shaderProg - ID of glsl shader
-	 * P - projection matrix
-	 * V - view matrix
-	 * C - transform matrix (such as for hand transformation)
+#ifndef DEDICATED_SERVER
+	/* Render function that takes into account the transform on top of the context's stack (such as for hand transformation)
+	 * context - render state of the pass (bounds.vert shader)
 	 */
-	void draw(GLuint shaderProg, glm::mat4 P, glm::mat4 V, glm::mat4 C);
+	void draw(const RenderContext & context);
+#endif
 	
 	// Updates the bounding box (uses the toWorld matrix)
 	void update();
@@ -58,7 +103,25 @@ public:
 	 */
 	void update(glm::mat4 transform_mat);
 	void spin(float deg);
+	/* Test the boxes from the last update of both bounds, and set both collision flags to the result
+	 * Uses the AABBs, then SAT on the oriented boxes if either bound's shape is BOUND_OBB
+	 * other - bound to test against
+	 */
 	bool check_collision(Bound * other);
+	/* Continuous version of check_collision: tests the volume this bound swept between its last two updates,
+	 * so a fast swing can't pass through the other bound between ticks. The other bound is taken where it is now
+	 * other - bound to test against
+	 * time_of_impact - if not NULL, set to the fraction of the motion (0 to 1) at the first contact
+	 */
+	bool check_swept_collision(Bound * other, float * time_of_impact = NULL);
+	/* The swept test against bare boxes (objects that share one Bound, like enemies). Leaves the collision flags alone
+	 * other_box - the other object's AABB
+	 * other_oriented_box - the other object's OBB
+	 * time_of_impact - if not NULL, set to the fraction of the motion (0 to 1) at the first contact
+	 */
+	bool sweptOverlap(const AABB & other_box, const OBB & other_oriented_box, float * time_of_impact = NULL);
+	// AABB of everything the box swept between its last two updates (for the broad phase)
+	AABB sweptBounds();
 
 	/* Vertices and indices for bounding boxes */
 	const GLuint indices[6][6] = {
@@ -85,6 +148,20 @@ public:
 		// "Back" vertices
 		{ -2.0, -2.0, -2.0 },{ 2.0, -2.0, -2.0 },{ 2.0,  2.0, -2.0 },{ -2.0,  2.0, -2.0 }
 	};
+
+private:
+	bool updated = false;			// Updated since construction (the next update has a previous box)
+	glm::vec3 local_center;			// Center of the vertices
+	glm::vec3 local_extent;			// Half size of the vertices along each axis
+
+	// Create the VAO/VBO/EBO used to draw the box
+	void init_buffers();
+	// Find local_center and local_extent from the vertices
+	void calc_extent();
+	/* How far the box moved between its last two updates, and its rotation at either end
+	 * returns -1 if there is no sweep to test (no previous box, or a jump over SWEEP_MAX_DISTANCE)
+	 */
+	float sweepDistance(glm::quat & from_rotation, glm::quat & to_rotation);
 };
 
 #endif
\ No newline at end of file
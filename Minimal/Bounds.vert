@@ -3,11 +3,23 @@
 layout (location = 0) in vec3 position;
 
 // Uniform variables can be updated by fetching their location and passing values to that location
-uniform mat4 projection;
-uniform mat4 modelview;
+uniform mat4 model;
+// Per-frame matrices shared by every shader (FrameUniforms.h). With single-pass stereo,
+// even instances draw the left eye and odd ones the right
+layout (std140) uniform Frame {
+    mat4 projection[2];
+    mat4 view[2];
+    int stereo;
+};
 
 void main()
 {
     // OpenGL maintains the D matrix so you only need to multiply by P, V (aka C inverse), and M
-    gl_Position = projection * modelview * vec4(position.x, position.y, position.z, 1.0);
+    int eye = stereo != 0 ? gl_InstanceID % 2 : 0;
+    gl_Position = projection[eye] * view[eye] * model * vec4(position.x, position.y, position.z, 1.0);
+    if (stereo != 0) {
+        // Squeeze into this eye's half of the side-by-side target and clip at the middle (Stereo.h)
+        gl_Position.x = gl_Position.x * 0.5 + (eye == 0 ? -0.5 : 0.5) * gl_Position.w;
+        gl_ClipDistance[0] = eye == 0 ? -gl_Position.x : gl_Position.x;
+    }
 }
\ No newline at end of file
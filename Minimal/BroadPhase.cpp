@@ -0,0 +1,141 @@
+#include "BroadPhase.h"
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+BroadPhase::BroadPhase(float cell_size) {
+	this->cell_size = cell_size;
+	origin[0] = origin[1] = 0.0f;
+	inv_cell_size = 1.0f / cell_size;
+	columns = rows = 0;
+	query_stamp = 0;
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+// Floor without the libm call: truncate, then step down for negative values that had a fraction
+static inline int floorToInt(float value) {
+	int truncated = (int)value;
+	return truncated - (value < (float)truncated);
+}
+
+static inline int clampCell(int cell, int count) {
+	return cell < 0 ? 0 : (cell >= count ? count - 1 : cell);
+}
+
+// Boxes outside the grid clamp to its border cells, which still hold every object they could overlap
+BroadPhase::CellRange BroadPhase::cellRange(const AABB & box) {
+	CellRange range;
+	range.min[0] = clampCell(floorToInt((box.min[0] - origin[0]) * inv_cell_size), columns);
+	range.min[1] = clampCell(floorToInt((box.min[2] - origin[1]) * inv_cell_size), rows);
+	range.max[0] = clampCell(floorToInt((box.max[0] - origin[0]) * inv_cell_size), columns);
+	range.max[1] = clampCell(floorToInt((box.max[2] - origin[1]) * inv_cell_size), rows);
+	return range;
+}
+
+void BroadPhase::build(const AABB * objects, const unsigned int * ids, unsigned int object_count) {
+	float min_x = objects[ids[0]].min[0], min_z = objects[ids[0]].min[2];
+	float max_x = objects[ids[0]].max[0], max_z = objects[ids[0]].max[2];
+	for (unsigned int i = 1; i < object_count; i++) {
+		const AABB & box = objects[ids[i]];
+		min_x = box.min[0] < min_x ? box.min[0] : min_x;
+		min_z = box.min[2] < min_z ? box.min[2] : min_z;
+		max_x = box.max[0] > max_x ? box.max[0] : max_x;
+		max_z = box.max[2] > max_z ? box.max[2] : max_z;
+	}
+
+	// Double the cells until the grid is no bigger than a few cells per object
+	float size = cell_size;
+	for (;;) {
+		columns = (int)((max_x - min_x) / size) + 1;
+		rows = (int)((max_z - min_z) / size) + 1;
+		if ((unsigned long long)columns * rows <= (unsigned long long)object_count * BROAD_PHASE_MAX_CELLS_PER_OBJECT) {
+			break;
+		}
+		size *= 2.0f;
+	}
+	origin[0] = min_x;
+	origin[1] = min_z;
+	inv_cell_size = 1.0f / size;
+
+	// Counting sort: count each cell's objects, turn the counts into ends, then fill each cell backwards
+	unsigned int cell_count = (unsigned int)(columns * rows);
+	cell_starts.assign(cell_count + 1, 0);
+	ranges.resize(object_count);
+	for (unsigned int i = 0; i < object_count; i++) {
+		CellRange range = cellRange(objects[ids[i]]);
+		ranges[i] = range;
+		for (int z = range.min[1]; z <= range.max[1]; z++) {
+			for (int x = range.min[0]; x <= range.max[0]; x++) {
+				cell_starts[z * columns + x]++;
+			}
+		}
+	}
+	unsigned int total = 0;
+	for (unsigned int c = 0; c < cell_count; c++) {
+		total += cell_starts[c];
+		cell_starts[c] = total;
+	}
+	cell_starts[cell_count] = total;
+	cell_objects.resize(total);
+	for (unsigned int i = object_count; i-- > 0;) {
+		const CellRange & range = ranges[i];
+		for (int z = range.min[1]; z <= range.max[1]; z++) {
+			for (int x = range.min[0]; x <= range.max[0]; x++) {
+				cell_objects[--cell_starts[z * columns + x]] = i;
+			}
+		}
+	}
+
+	if (stamps.size() < object_count) {
+		stamps.resize(object_count, 0);
+	}
+}
+
+// A new stamp marks objects already listed by this query. Reset them all if it ever wraps
+void BroadPhase::nextStamp() {
+	if (++query_stamp == 0) {
+		for (unsigned int & stamp : stamps) {
+			stamp = 0;
+		}
+		query_stamp = 1;
+	}
+}
+
+/*------------------------ PUBLIC FUNCTIONS ---------------------------*/
+void BroadPhase::queryPairs(const AABB * objects, const unsigned int * ids, unsigned int object_count,
+	const AABB * queries, unsigned int query_count, std::vector<BroadPhasePair> & pairs) {
+	pairs.clear();
+	if (object_count == 0) {
+		return;
+	}
+
+	if (query_count < BROAD_PHASE_GRID_MIN_QUERIES) {
+		for (unsigned int q = 0; q < query_count; q++) {
+			for (unsigned int i = 0; i < object_count; i++) {
+				if (aabbOverlap(objects[ids[i]], queries[q])) {
+					BroadPhasePair pair = { q, ids[i] };
+					pairs.push_back(pair);
+				}
+			}
+		}
+		return;
+	}
+
+	build(objects, ids, object_count);
+	for (unsigned int q = 0; q < query_count; q++) {
+		const AABB & box = queries[q];
+		nextStamp();
+		CellRange range = cellRange(box);
+		for (int z = range.min[1]; z <= range.max[1]; z++) {
+			for (int x = range.min[0]; x <= range.max[0]; x++) {
+				unsigned int cell = z * columns + x;
+				for (unsigned int entry = cell_starts[cell]; entry < cell_starts[cell + 1]; entry++) {
+					unsigned int i = cell_objects[entry];
+					if (stamps[i] != query_stamp && aabbOverlap(objects[ids[i]], box)) {
+						BroadPhasePair pair = { q, ids[i] };
+						pairs.push_back(pair);
+					}
+					stamps[i] = query_stamp;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/* Broad phase for hitboxes: finds the overlapping pairs between a batch of query boxes and the caller's
+ * object boxes, read in place (nothing is copied or kept between calls). A big batch bins the objects into a
+ * uniform grid of x/z columns over their bounds first, built with two passes of a counting sort into flat
+ * arrays, so there is no hashing and nothing is allocated once the arrays have grown. With only a few query
+ * boxes (the swords) testing every object directly is cheaper than binning them, so the grid is skipped.
+ */
+#pragma once
+#ifndef _BROAD_PHASE_H_
+#define _BROAD_PHASE_H_
+
+#include "Bound.h"
+#include <vector>
+
+// Side of a grid cell in world units. About the size of an enemy, so most sit in one to four columns
+#define BROAD_PHASE_CELL_SIZE 1.0f
+// Fewer query boxes than this test every object instead of building the grid (see --bench on the server)
+#define BROAD_PHASE_GRID_MIN_QUERIES 8
+// Cells per object at most. Objects spread far apart get bigger cells instead of a mostly empty grid
+#define BROAD_PHASE_MAX_CELLS_PER_OBJECT 4
+
+// A query box against an object whose AABBs overlap (the narrow phase decides if they really hit)
+struct BroadPhasePair {
+	unsigned int query;				// Index of the query box
+	unsigned int id;				// Object id
+};
+
+class BroadPhase {
+public:
+	/* BroadPhase constructor
+	 * cell_size - side of a grid cell in world units
+	 */
+	BroadPhase(float cell_size = BROAD_PHASE_CELL_SIZE);
+
+	/* Candidate pairs between query boxes and objects. Builds the grid when there are at least
+	 * BROAD_PHASE_GRID_MIN_QUERIES query boxes, otherwise tests every pair
+	 * objects - object boxes, indexed by id
+	 * ids - the ids to test (e.g. the live pool slots)
+	 * object_count - number of ids
+	 * queries - query boxes
+	 * query_count - number of query boxes
+	 * pairs - cleared, then filled in query order
+	 */
+	void queryPairs(const AABB * objects, const unsigned int * ids, unsigned int object_count,
+		const AABB * queries, unsigned int query_count, std::vector<BroadPhasePair> & pairs);
+
+private:
+	struct CellRange {
+		int min[2];					// Column and row of the box's min corner
+		int max[2];
+	};
+
+	float cell_size;
+	float origin[2];
+	float inv_cell_size;
+	int columns;
+	int rows;
+	std::vector<CellRange> ranges;			// Cells of each object, by position in ids
+	std::vector<unsigned int> cell_starts;	// First entry of each cell in cell_objects, plus the end
+	std::vector<unsigned int> cell_objects;	// Positions in ids, grouped by cell
+	std::vector<unsigned int> stamps;		// Last query that listed the object (dedups objects in several cells)
+	unsigned int query_stamp;
+
+	void build(const AABB * objects, const unsigned int * ids, unsigned int object_count);
+	CellRange cellRange(const AABB & box);
+	void nextStamp();
+};
+
+#endif
@@ -1,22 +1,21 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "ClientGame.h"
 
 
-ClientGame::ClientGame(void)
+ClientGame::ClientGame(bool use_udp)
 {
 
-    network = new ClientNetwork();
+    network = new ClientNetwork(use_udp);
 
     // send init packet
-    const unsigned int packet_size = sizeof(Packet);
-    char packet_data[packet_size];
+    char packet_data[MAX_FRAMED_PACKET_SIZE];
 
     Packet packet;
     packet.packet_type = INIT_CONNECTION;
 
-    packet.serialize(packet_data);
+    unsigned int packet_size = packet.serializeFrame(packet_data);
 
-    NetworkServices::sendMessage(network->ConnectSocket, packet_data, packet_size);
+    network->sendPackets(packet_data, packet_size);
 }
 
 
@@ -27,52 +26,77 @@ ClientGame::~ClientGame(void)
 void ClientGame::sendActionPackets()
 {
     // send action packet
-    const unsigned int packet_size = sizeof(Packet);
-    char packet_data[packet_size];
+    char packet_data[MAX_FRAMED_PACKET_SIZE];
 
     Packet packet;
     packet.packet_type = ACTION_EVENT;
 
-    packet.serialize(packet_data);
+    unsigned int packet_size = packet.serializeFrame(packet_data);
 
-    NetworkServices::sendMessage(network->ConnectSocket, packet_data, packet_size);
+    network->sendPackets(packet_data, packet_size);
 }
 
 void ClientGame::sendPackets(glm::mat4 hand_transform, glm::mat4 head_transform) {
 	// Initialize buffer
-	const unsigned int packet_size = sizeof(Packet);
-	char packet_data[packet_size];
+	char packet_data[MAX_FRAMED_PACKET_SIZE];
 
 	// Fill data to send with player 2 data
 	Packet packet;
 	packet.packet_type = HEAD_HAND_TRANSFORMS;
 	packet.hand_transform = hand_transform;
 	packet.head_transform = head_transform;
+	// Acknowledge the newest snapshot so the server can send deltas against it
+	packet.ack = snapshotReceived ? snapshot.sequence : SNAPSHOT_NO_ACK;
+	packet.time = PoseBuffer::timestampMs();
 
-	packet.serialize(packet_data);
+	unsigned int packet_size = packet.serializeFrame(packet_data);
 
-	NetworkServices::sendMessage(network->ConnectSocket, packet_data, packet_size);
+	// Only the newest pose matters, so a lost one is never resent
+	network->sendUnreliable(packet_data, packet_size);
 }
 
 void ClientGame::update()
 {
     Packet packet;
-    int data_length = network->receivePackets(network_data);
+    network->flushPending();
+    network->receivePackets();
 
-    if (data_length <= 0) 
-    {
-        //no data recieved
-        return;
-    }
+    char * frame;
+    unsigned int frame_length;
 
-    int i = 0;
-    while (i < (unsigned int)data_length) 
+    // handle every complete frame (TCP first, then UDP), a partial one stays buffered until the rest arrives
+    FrameBuffer * channels[2] = { &network->recv_frames, &network->datagram_frames };
+    unsigned int channel = 0;
+
+    while (channel < 2) 
     {
-        packet.deserialize(&(network_data[i]));
-        i += sizeof(Packet);
+        if (!channels[channel]->nextFrame(frame, frame_length))
+        {
+            channel++;
+            continue;
+        }
+
+        // snapshots have their own variable length encoding
+        if (frame_length > 0 && (unsigned char)frame[0] == WORLD_SNAPSHOT)
+        {
+            receiveSnapshot(frame + 1, frame_length - 1);
+            continue;
+        }
+
+        if (!packet.deserialize(frame, frame_length))
+        {
+            printf("error in packet size\n");
+            continue;
+        }
 
         switch (packet.packet_type) {
 
+            case UDP_CONNECT:
+
+                network->setUdpToken(packet.token);
+
+                break;
+
             case ACTION_EVENT:
 
                 printf("client received action event packet from server. Successful connection!\n");
@@ -87,12 +111,12 @@ void ClientGame::update()
 				break;
 
 			case TRANSFORMS_AND_INDICES:
-				//printf("client received transforms and path index data from server\n");
+				//printf("client received transforms and path position data from server\n");
 				// Fill data
 				receivedHandTransform = packet.hand_transform;
 				receivedHeadTransform = packet.head_transform;
 				for (unsigned int i = 0; i < 4; i++) {
-					receivedPathInds[i] = packet.indices[i];
+					receivedPathPositions[i] = packet.positions[i];
 				}
 				break;
 
@@ -104,3 +128,38 @@ void ClientGame::update()
         }
     }
 }
+
+void ClientGame::receiveSnapshot(char * data, unsigned int length)
+{
+	WorldSnapshot received;
+	if (!received.readDelta(data, length, snapshot_history))
+	{
+		printf("client dropped a snapshot it could not decode\n");
+		return;
+	}
+
+	// TCP delivers in order, but never let an old snapshot replace a newer one
+	if (snapshotReceived && (short)(received.sequence - snapshot.sequence) <= 0)
+	{
+		return;
+	}
+
+	snapshot_history.store(received);
+	snapshot = received;
+	snapshotReceived = true;
+
+	// Our own pose is left out, so the remaining player is the other one
+	if (!snapshot.players.empty())
+	{
+		receivedHandTransform = snapshot.players[0].hand_transform;
+		receivedHeadTransform = snapshot.players[0].head_transform;
+		remotePose.push(snapshot.players[0].time, PoseBuffer::localTime(), receivedHandTransform, receivedHeadTransform);
+	}
+	for (const EntityState & entity : snapshot.entities)
+	{
+		if (entity.path < 4)
+		{
+			receivedPathPositions[entity.path] = entity.positionAt(snapshot.time);
+		}
+	}
+}
@@ -1,14 +1,17 @@
 #pragma once
-#include <winsock2.h>
-#include <Windows.h>
 #include "ClientNetwork.h"
 #include "NetworkData.h"
+#include "Snapshot.h"
+#include "PoseBuffer.h"
 
 
 class ClientGame
 {
 public:
-	ClientGame(void);
+	/* ClientGame constructor
+	 * use_udp - send poses and receive snapshots over UDP when the server supports it
+	 */
+	ClientGame(bool use_udp = false);
 	~ClientGame(void);
 
 	ClientNetwork* network;
@@ -16,8 +19,15 @@ public:
 	/* Data the ClientGame receives from the server */
 	glm::mat4 receivedHandTransform;
 	glm::mat4 receivedHeadTransform;
-	unsigned int receivedPathInds[4];
+	float receivedPathPositions[4];
+
+	// Latest world state from the server and the recent ones it may send deltas against
+	WorldSnapshot snapshot;
+	SnapshotHistory snapshot_history;
+	bool snapshotReceived = false;
 
+	// Other player's poses from the snapshots, played back smoothly
+	PoseBuffer remotePose;
 
 	// Check if player 1 has been found
 	bool player1Found = false;
@@ -29,8 +39,10 @@ public:
 	 */
 	void sendPackets(glm::mat4 hand_transform, glm::mat4 head_transform);
 
-    char network_data[MAX_PACKET_SIZE];
-
     void update();
+
+private:
+	// Apply a WORLD_SNAPSHOT frame (without the type byte)
+	void receiveSnapshot(char * data, unsigned int length);
 };
 
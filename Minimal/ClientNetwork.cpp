@@ -1,32 +1,34 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "ClientNetwork.h"
+#include <string.h>
 
 
-ClientNetwork::ClientNetwork(void)
+ClientNetwork::ClientNetwork(bool use_udp)
 {
-    // create WSADATA object
-    WSADATA wsaData;
-
     // socket
     ConnectSocket = INVALID_SOCKET;
+    UdpSocket = INVALID_SOCKET;
+    bytes_sent = 0;
+    udp_token = 0;
+    udp_confirmed = false;
 
     // holds address info for socket to connect to
     struct addrinfo *result = NULL,
                     *ptr = NULL,
                     hints;
 
-    // Initialize Winsock
-    iResult = WSAStartup(MAKEWORD(2,2), &wsaData);
+    // Initialize the socket library
+    iResult = NetworkServices::initialize();
 
     if (iResult != 0) {
-        printf("WSAStartup failed with error: %d\n", iResult);
+        printf("socket startup failed with error: %d\n", iResult);
         exit(1);
     }
 
 
 
     // set address info
-    ZeroMemory( &hints, sizeof(hints) );
+    memset( &hints, 0, sizeof(hints) );
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;  //TCP connection!!!
@@ -38,7 +40,7 @@ ClientNetwork::ClientNetwork(void)
     if( iResult != 0 ) 
     {
         printf("getaddrinfo failed with error: %d\n", iResult);
-        WSACleanup();
+        NetworkServices::cleanup();
         exit(1);
     }
 
@@ -50,8 +52,8 @@ ClientNetwork::ClientNetwork(void)
             ptr->ai_protocol);
 
         if (ConnectSocket == INVALID_SOCKET) {
-            printf("socket failed with error: %ld\n", WSAGetLastError());
-            WSACleanup();
+            printf("socket failed with error: %d\n", NetworkServices::getLastError());
+            NetworkServices::cleanup();
             exit(1);
         }
 
@@ -60,7 +62,7 @@ ClientNetwork::ClientNetwork(void)
 
         if (iResult == SOCKET_ERROR)
         {
-            closesocket(ConnectSocket);
+            NetworkServices::closeSocket(ConnectSocket);
             ConnectSocket = INVALID_SOCKET;
             printf ("The server is down... did not connect");
         }
@@ -77,25 +79,45 @@ ClientNetwork::ClientNetwork(void)
     if (ConnectSocket == INVALID_SOCKET) 
     {
         printf("Unable to connect to server!\n");
-        WSACleanup();
+        NetworkServices::cleanup();
         exit(1);
     }
 
 	// Set the mode of the socket to be nonblocking
-    u_long iMode = 1;
-
-    iResult = ioctlsocket(ConnectSocket, FIONBIO, &iMode);
+    iResult = NetworkServices::setNonBlocking(ConnectSocket);
     if (iResult == SOCKET_ERROR)
     {
-        printf("ioctlsocket failed with error: %d\n", WSAGetLastError());
-        closesocket(ConnectSocket);
-        WSACleanup();
+        printf("setting nonblocking mode failed with error: %d\n", NetworkServices::getLastError());
+        NetworkServices::closeSocket(ConnectSocket);
+        NetworkServices::cleanup();
         exit(1);        
     }
 
 	//disable nagle
-    char value = 1;
-    setsockopt( ConnectSocket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof( value ) );
+    NetworkServices::disableNagle(ConnectSocket);
+
+    if (use_udp)
+    {
+        // UDP socket connected to the same server address and port, so only its datagrams are received
+        sockaddr_storage server_address;
+        socklen_t server_address_size = sizeof(server_address);
+
+        if (getpeername(ConnectSocket, (sockaddr *)&server_address, &server_address_size) == 0)
+        {
+            UdpSocket = socket(server_address.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        }
+        if (UdpSocket != INVALID_SOCKET &&
+            (connect(UdpSocket, (sockaddr *)&server_address, server_address_size) == SOCKET_ERROR ||
+             NetworkServices::setNonBlocking(UdpSocket) == SOCKET_ERROR))
+        {
+            NetworkServices::closeSocket(UdpSocket);
+            UdpSocket = INVALID_SOCKET;
+        }
+        if (UdpSocket == INVALID_SOCKET)
+        {
+            printf("UDP socket unavailable (error %d), using TCP only\n", NetworkServices::getLastError());
+        }
+    }
 }
 
 
@@ -103,17 +125,146 @@ ClientNetwork::~ClientNetwork(void)
 {
 }
 
-int ClientNetwork::receivePackets(char * recvbuf) 
+int ClientNetwork::receivePackets() 
 {
-    iResult = NetworkServices::receiveMessage(ConnectSocket, recvbuf, MAX_PACKET_SIZE);
+    int total = receiveDatagrams();
 
-    if ( iResult == 0 )
+    while (true)
     {
-        printf("Connection closed\n");
-        closesocket(ConnectSocket);
-        WSACleanup();
-        exit(1);
+        unsigned int space;
+        char * recvbuf = recv_frames.writePtr(space);
+
+        // the rest is read next update, once ClientGame has consumed some frames
+        if (space == 0)
+        {
+            return total;
+        }
+
+        iResult = NetworkServices::receiveMessage(ConnectSocket, recvbuf, space);
+
+        if ( iResult == 0 )
+        {
+            printf("Connection closed\n");
+            NetworkServices::closeSocket(ConnectSocket);
+            NetworkServices::cleanup();
+            exit(1);
+        }
+
+        if (iResult < 0)
+        {
+            return total;
+        }
+
+        recv_frames.commitWrite(iResult);
+        total += iResult;
+    }
+}
+
+void ClientNetwork::sendPackets(char * packets, int totalSize)
+{
+    send_buf.insert(send_buf.end(), packets, packets + totalSize);
+    flushPending();
+}
+
+void ClientNetwork::flushPending()
+{
+    size_t sent = 0;
+
+    while (sent < send_buf.size())
+    {
+        iResult = NetworkServices::sendMessage(ConnectSocket, &send_buf[sent], (int)(send_buf.size() - sent));
+
+        if (iResult == SOCKET_ERROR)
+        {
+            int error = NetworkServices::getLastError();
+            if (!NetworkServices::wouldBlock(error))
+            {
+                printf("send failed with error: %d\n", error);
+                send_buf.clear();
+                return;
+            }
+            break;
+        }
+        sent += iResult;
+        bytes_sent += iResult;
+    }
+
+    send_buf.erase(send_buf.begin(), send_buf.begin() + sent);
+}
+
+void ClientNetwork::setUdpToken(unsigned int token)
+{
+    udp_token = token;
+}
+
+void ClientNetwork::sendUnreliable(char * frame, int frameSize)
+{
+    int payload_size = frameSize - FRAME_HEADER_SIZE;
+    if (UdpSocket == INVALID_SOCKET || udp_token == 0 || payload_size > UDP_MAX_PAYLOAD)
+    {
+        sendPackets(frame, frameSize);
+        return;
     }
 
-    return iResult;
+    char datagram[UDP_MAX_DATAGRAM];
+    for (unsigned int i = 0; i < UDP_TOKEN_SIZE; i++)
+    {
+        datagram[i] = (char)((udp_token >> (8 * i)) & 0xFF);
+    }
+    unsigned short sequence = udp.nextSequence();
+    datagram[UDP_TOKEN_SIZE] = (char)(sequence & 0xFF);
+    datagram[UDP_TOKEN_SIZE + 1] = (char)(sequence >> 8);
+    memcpy(datagram + UDP_TOKEN_SIZE + UDP_SEQUENCE_SIZE, frame + FRAME_HEADER_SIZE, payload_size);
+
+    iResult = NetworkServices::sendMessage(UdpSocket, datagram, UDP_TOKEN_SIZE + UDP_SEQUENCE_SIZE + payload_size);
+    if (iResult > 0)
+    {
+        bytes_sent += iResult;
+    }
+
+    // the datagram is what tells the server our address, but until it answers UDP might be blocked
+    if (!udp_confirmed)
+    {
+        sendPackets(frame, frameSize);
+    }
+}
+
+int ClientNetwork::receiveDatagrams()
+{
+    if (UdpSocket == INVALID_SOCKET)
+    {
+        return 0;
+    }
+
+    char datagram[UDP_SEQUENCE_SIZE + UDP_MAX_PAYLOAD];
+    int total = 0;
+
+    while (true)
+    {
+        iResult = NetworkServices::receiveMessage(UdpSocket, datagram, sizeof(datagram));
+
+        if (iResult == SOCKET_ERROR)
+        {
+            // errors like ICMP port unreachable only concern one datagram, keep draining
+            if (NetworkServices::wouldBlock(NetworkServices::getLastError()))
+            {
+                return total;
+            }
+            continue;
+        }
+        if (iResult <= UDP_SEQUENCE_SIZE)
+        {
+            continue;
+        }
+        total += iResult;
+
+        unsigned short sequence = (unsigned short)((unsigned char)datagram[0] | ((unsigned char)datagram[1] << 8));
+        if (!udp.accept(sequence))
+        {
+            continue;
+        }
+        udp_confirmed = true;
+
+        datagram_frames.pushFrame(datagram + UDP_SEQUENCE_SIZE, iResult - UDP_SEQUENCE_SIZE);
+    }
 }
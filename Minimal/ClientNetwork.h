@@ -1,36 +1,74 @@
 #pragma once
 // Networking libraries
-#include <winsock2.h>
-#include <Windows.h>
 #include "NetworkServices.h"
-#include <ws2tcpip.h>
 #include <stdio.h> 
+#include <vector>
 #include "NetworkData.h"
+#include "FrameBuffer.h"
 
 // size of our buffer
 #define DEFAULT_BUFLEN 512
 // port to connect sockets through 
 #define DEFAULT_PORT "6881"
+#ifdef _WIN32
 // Need to link with Ws2_32.lib, Mswsock.lib, and Advapi32.lib
 #pragma comment (lib, "Ws2_32.lib")
 #pragma comment (lib, "Mswsock.lib")
 #pragma comment (lib, "AdvApi32.lib")
+#endif
 
 class ClientNetwork
 {
 
 public:
 
-    // for error checking function calls in Winsock library
+    // for error checking function calls in the socket library
     int iResult;
 
     // socket for client to connect to server
     SOCKET ConnectSocket;
 
-    // ctor/dtor
-    ClientNetwork(void);
+    // bytes written to the server since startup
+    unsigned long long bytes_sent;
+
+    // UDP socket connected to the server, INVALID_SOCKET when UDP is off
+    SOCKET UdpSocket;
+
+    /* ClientNetwork constructor
+     * use_udp - send poses over UDP once the server hands out a token (falls back to TCP)
+     */
+    ClientNetwork(bool use_udp = false);
     ~ClientNetwork(void);
 
-	int receivePackets(char *);
+    // bytes received from the server, consumed frame by frame by ClientGame
+    FrameBuffer recv_frames;
+    // payloads of accepted datagrams from the server
+    FrameBuffer datagram_frames;
+
+	// Read everything the server has sent into recv_frames and datagram_frames. Returns the number of bytes read
+	int receivePackets();
+
+	// Token from the server's UDP_CONNECT packet. Opens the UDP path
+	void setUdpToken(unsigned int token);
+
+	/* Send a frame on the unreliable sequenced channel
+	 * Until a datagram from the server proves UDP works both ways, the frame also goes over TCP
+	 */
+	void sendUnreliable(char * frame, int frameSize);
+
+	// Send framed packets. Whatever the socket does not take now is sent on the next flushPending
+	void sendPackets(char * packets, int totalSize);
+	// Retry the bytes a previous send could not write
+	void flushPending();
+
+private:
+    // bytes not yet accepted by the socket, so frames are never cut in half on the wire
+    std::vector<char> send_buf;
+
+    unsigned int udp_token;
+    bool udp_confirmed;             // a datagram from the server has arrived
+    SequencedChannel udp;
+
+    int receiveDatagrams();
 };
 
@@ -2,11 +2,35 @@
 
 #define DEFAULT_NUM_SAMPLES 150.0f
 
+// Vector ops for the batch evaluator, widest instruction set the compiler targets
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CURVE_SIMD_WIDTH 8
+#define SIMD_VEC __m256
+#define SIMD_SET1 _mm256_set1_ps
+#define SIMD_LOAD _mm256_loadu_ps
+#define SIMD_STORE _mm256_storeu_ps
+#define SIMD_ADD _mm256_add_ps
+#define SIMD_MUL _mm256_mul_ps
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CURVE_SIMD_WIDTH 4
+#define SIMD_VEC __m128
+#define SIMD_SET1 _mm_set1_ps
+#define SIMD_LOAD _mm_loadu_ps
+#define SIMD_STORE _mm_storeu_ps
+#define SIMD_ADD _mm_add_ps
+#define SIMD_MUL _mm_mul_ps
+#else
+#define CURVE_SIMD_WIDTH 1
+#endif
+
 Curve::Curve() {
 	g_bez = glm::mat4(1.0f);
 	c_bez = g_bez * b_bez;
 	toWorld = glm::mat4(1.0f);
 	num_samples = DEFAULT_NUM_SAMPLES;
+	calc_arc_lengths();
 	calc_pnts();
 	init_buffers();
 }
@@ -16,6 +40,7 @@ Curve::Curve(glm::mat4 cont_pts) {
 	c_bez = g_bez * b_bez;
 	toWorld = glm::mat4(1.0f);
 	num_samples = DEFAULT_NUM_SAMPLES;
+	calc_arc_lengths();
 	calc_pnts();
 	init_buffers();
 
@@ -26,32 +51,134 @@ Curve::Curve(glm::mat4 cont_pts, unsigned int n) {
 	c_bez = g_bez * b_bez;
 	toWorld = glm::mat4(1.0f);
 	num_samples = n;
+	calc_arc_lengths();
 	calc_pnts();
 	init_buffers();
 
 }
 
 Curve::~Curve() {
+#ifndef DEDICATED_SERVER
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
 	glDeleteBuffers(1, &EBO);
+	glState().deletedVertexArray(VAO);
+	glState().deletedBuffer(VBO);
+	glState().deletedBuffer(EBO);
+#endif
 }
 
 std::vector<glm::vec3> & Curve::getVertices() {
 	return vertices;
 }
 
+glm::vec3 Curve::evaluate(float t) {
+	return ((coeffs[0] * t + coeffs[1]) * t + coeffs[2]) * t + coeffs[3];
+}
+
+float Curve::length() {
+	return arc_lengths[ARC_LENGTH_SEGMENTS];
+}
+
+float Curve::paramAtDistance(float distance) {
+	if (distance <= 0.0f) {
+		return 0.0f;
+	}
+	if (distance >= arc_lengths[ARC_LENGTH_SEGMENTS]) {
+		return 1.0f;
+	}
+
+	// Find the last table entry at or before the distance
+	unsigned int low = 0;
+	unsigned int high = ARC_LENGTH_SEGMENTS;
+	while (high - low > 1) {
+		unsigned int mid = (low + high) / 2;
+		if (arc_lengths[mid] <= distance) {
+			low = mid;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	float segment = arc_lengths[high] - arc_lengths[low];
+	float fraction = segment > 0.0f ? (distance - arc_lengths[low]) / segment : 0.0f;
+	return (low + fraction) / ARC_LENGTH_SEGMENTS;
+}
+
+glm::vec3 Curve::pointAtDistance(float distance) {
+	return evaluate(paramAtDistance(distance));
+}
+
+void Curve::evaluateBatch(const float * params, unsigned int count, CurveSamples & out, bool use_simd) {
+	out.resize(count);
+	unsigned int i = 0;
+
+#if CURVE_SIMD_WIDTH > 1
+	if (use_simd) {
+		// Coefficients are the same for every point, so broadcast them once: a, b, c, d per axis,
+		// plus 3a and 2b for the tangent
+		SIMD_VEC a[3], b[3], c[3], d[3], a3[3], b2[3];
+		for (unsigned int axis = 0; axis < 3; axis++) {
+			a[axis] = SIMD_SET1(coeffs[0][axis]);
+			b[axis] = SIMD_SET1(coeffs[1][axis]);
+			c[axis] = SIMD_SET1(coeffs[2][axis]);
+			d[axis] = SIMD_SET1(coeffs[3][axis]);
+			a3[axis] = SIMD_SET1(3.0f * coeffs[0][axis]);
+			b2[axis] = SIMD_SET1(2.0f * coeffs[1][axis]);
+		}
+		float * pos[3] = { out.x.data(), out.y.data(), out.z.data() };
+		float * tan[3] = { out.tx.data(), out.ty.data(), out.tz.data() };
+
+		for (; i + CURVE_SIMD_WIDTH <= count; i += CURVE_SIMD_WIDTH) {
+			SIMD_VEC t = SIMD_LOAD(params + i);
+			SIMD_STORE(out.t.data() + i, t);
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				SIMD_VEC p = SIMD_ADD(SIMD_MUL(SIMD_ADD(SIMD_MUL(SIMD_ADD(SIMD_MUL(a[axis], t), b[axis]), t), c[axis]), t), d[axis]);
+				SIMD_VEC dp = SIMD_ADD(SIMD_MUL(SIMD_ADD(SIMD_MUL(a3[axis], t), b2[axis]), t), c[axis]);
+				SIMD_STORE(pos[axis] + i, p);
+				SIMD_STORE(tan[axis] + i, dp);
+			}
+		}
+	}
+#endif
+
+	// Scalar fallback, and the tail that does not fill a whole register
+	for (; i < count; i++) {
+		float t = params[i];
+		glm::vec3 p = evaluate(t);
+		glm::vec3 dp = (3.0f * coeffs[0] * t + 2.0f * coeffs[1]) * t + coeffs[2];
+		out.t[i] = t;
+		out.x[i] = p.x; out.y[i] = p.y; out.z[i] = p.z;
+		out.tx[i] = dp.x; out.ty[i] = dp.y; out.tz[i] = dp.z;
+	}
+}
+
+void Curve::evaluateBatchAtDistances(const float * distances, unsigned int count, CurveSamples & out) {
+	// The table lookup is a search, so it stays scalar. The parameters are written in place and evaluated as a batch
+	out.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		out.t[i] = paramAtDistance(distances[i]);
+	}
+	evaluateBatch(out.t.data(), count, out);
+}
+
+unsigned int Curve::simdWidth() {
+	return CURVE_SIMD_WIDTH;
+}
+
 void Curve::init_buffers() {
+#ifndef DEDICATED_SERVER
 	// Create array object & buffers
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 
 	// Bind vertex array buffer
-	glBindVertexArray(VAO);
+	glState().bindVertexArray(VAO);
 
 	// Bind vertex buffer object
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
 	// Enable the usage of layout location 0 (check the vertex shader to see what this is)
@@ -59,54 +186,49 @@ void Curve::init_buffers() {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
 
 	// Bind index buffer object
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
 
 	// Unbind the currently bound buffer so that we don't accidentally make unwanted changes to it.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glState().bindBuffer(GL_ARRAY_BUFFER, 0);
 
 	// Unbind the VAO now so we don't accidentally tamper with it.
-	glBindVertexArray(0);
-}
-
-void Curve::draw(GLint shaderProgram, glm::mat4 P, glm::mat4 V) {
-	// Calculate the combination of the model and view (camera inverse) matrices
-	glm::mat4 modelview = V * toWorld;
-
-	// Get the location of the uniform variables "projection" and "modelview"
-	/*
-	uProjection = glGetUniformLocation(shaderProgram, "projection");
-	uModelview = glGetUniformLocation(shaderProgram, "modelview");
-	// Now send these values to the shader program
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &P[0][0]);
-	glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
-	*/
-	// What should actually be sent to the shader
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &toWorld[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &V[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &P[0][0]);
+	glState().bindVertexArray(0);
+#endif
+}
+
+#ifndef DEDICATED_SERVER
+void Curve::draw(const RenderContext & context) {
+	// What should actually be sent to the shader (the projection and view come from the Frame block)
+	context.shader->setMat4(UNIFORM_MODEL, toWorld);
 	// Now draw the cube. We simply need to bind the VAO associated with it.
-	glBindVertexArray(VAO);
+	glState().bindVertexArray(VAO);
 	// Tell OpenGL to draw with triangles, using 36 indices, the type of the indices, and the offset to start from
 	//glDrawElements(GL_LINES, indices.size(), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_LINE_STRIP, 0, indices.size());
-	// Unbind the VAO when we're done so we don't accidentally draw extra stuff or tamper with its bound buffers
-	glBindVertexArray(0);
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, indices.size(), stereoInstances(1));
 }
+#endif
 
 void Curve::calc_pnts() {
-	glm::vec4 pnt(1.0f);
-	float denominator3 = (num_samples * num_samples * num_samples);
-	float denominator2 = num_samples * num_samples;
-
 	// Add calculated points as vertices
-	vertices.push_back(glm::vec3(c_bez * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	vertices.push_back(evaluate(0.0f));
 	for (unsigned int i = 0; i < num_samples; i++) {
-		pnt.x = ((i + 1.0f) * (i + 1.0f) * (i + 1.0f)) / denominator3;
-		pnt.y = ((i + 1.0f) * (i + 1.0f)) / denominator2;
-		pnt.z = (i + 1.0f) / num_samples;
-		vertices.push_back(glm::vec3(c_bez * pnt));
+		vertices.push_back(evaluate((i + 1.0f) / num_samples));
 		indices.push_back(i);
 	}
 	indices.push_back(num_samples);
-}
\ No newline at end of file
+}
+
+void Curve::calc_arc_lengths() {
+	for (unsigned int i = 0; i < 4; i++) {
+		coeffs[i] = glm::vec3(c_bez[i]);
+	}
+
+	glm::vec3 prev = evaluate(0.0f);
+	arc_lengths[0] = 0.0f;
+	for (unsigned int i = 1; i <= ARC_LENGTH_SEGMENTS; i++) {
+		glm::vec3 pnt = evaluate((float)i / ARC_LENGTH_SEGMENTS);
+		arc_lengths[i] = arc_lengths[i - 1] + glm::length(pnt - prev);
+		prev = pnt;
+	}
+}
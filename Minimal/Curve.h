@@ -1,10 +1,11 @@
 /* By Ronald Allan Baldonado
- * Header class defining implementation of uniform sampled bezier curve
+ * Header class defining implementation of a cubic bezier curve, evaluated by arc length
  * Particular implementation used for defining enemy path in game
  */
 #pragma once
 #ifndef CURVE_H
 #define CURVE_H
+#ifndef DEDICATED_SERVER
 #define GLFW_INCLUDE_GLEXT
 #ifdef __APPLE__
 #define GLFW_INCLUDE_GLCOREARB
@@ -12,18 +13,39 @@
 #include <GL/glew.h>
 #endif
 #include <GLFW/glfw3.h>
+#include "RenderContext.h"
+#else
+// The dedicated server has no GL context, only the path sampling is compiled
+typedef int GLint;
+typedef unsigned int GLuint;
+#endif
 // Use of degrees is deprecated. Use radians instead.
 #ifndef GLM_FORCE_RADIANS
 #define GLM_FORCE_RADIANS
 #endif
 
-#include <GLFW/glfw3.h>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 
 #endif
 
+// Segments in the arc-length table. Distances between table entries are interpolated linearly
+#define ARC_LENGTH_SEGMENTS 128
+
+// Positions and tangents of a batch of points on a curve, one array per component (SoA) so they load straight into SIMD registers
+struct CurveSamples {
+	std::vector<float> t;				// Curve parameter of each point
+	std::vector<float> x, y, z;			// Position
+	std::vector<float> tx, ty, tz;		// Tangent (derivative with respect to t, not normalized)
+
+	void resize(unsigned int count) {
+		t.resize(count);
+		x.resize(count); y.resize(count); z.resize(count);
+		tx.resize(count); ty.resize(count); tz.resize(count);
+	}
+};
+
 class Curve {
 private:
 	/* Data */
@@ -37,7 +59,9 @@ private:
 
 	glm::mat4 g_bez;	// Column vectors make up control points
 	glm::mat4 c_bez;	// Multiply g_bez by b_bez
-	float num_samples;
+	glm::vec3 coeffs[4];	// Power basis coefficients of the curve (t^3, t^2, t, 1), from c_bez
+	float num_samples;		// Vertices in the debug line strip
+	float arc_lengths[ARC_LENGTH_SEGMENTS + 1];		// Distance along the curve at t = i / ARC_LENGTH_SEGMENTS
 	
 	glm::mat4 toWorld;
 	std::vector<glm::vec3> vertices;
@@ -45,13 +69,14 @@ private:
 
 	// These variables are needed for the shader program
 	GLuint VBO, VAO, EBO;
-	GLuint uProjection, uModelview;
 
 	/* Private functions */
 	// Initialize buffers for debug drawing the curve
 	void init_buffers();
 	// Calculates points on curve based on number of samples and fills vertices and indices
 	void calc_pnts();
+	// Fills arc_lengths by summing chords between evenly spaced parameters
+	void calc_arc_lengths();
 public:
 	/* Public Functions*/
 	Curve();
@@ -61,17 +86,48 @@ public:
 	Curve(glm::mat4 control_pts);
 	/* Curve constructor.
 	 * control_pts - 4x4 matrix where each column defines a 4-vector for a bezier curve control point
-	 * num_samples - Number of samples
+	 * num_samples - Number of line segments the curve is drawn with
 	 */
 	Curve(glm::mat4 control_pts, unsigned int num_samples);		// Pick your own number of samples by passing it in as num_samples
 	~Curve();
 
-	// Curve vertices getter method
+	// Curve vertices getter method (the debug line strip)
 	std::vector<glm::vec3> & getVertices();			
+
+	/* Point on the curve at parameter t, evaluated in Horner form
+	 * t - curve parameter in [0, 1]
+	 */
+	glm::vec3 evaluate(float t);
+	// Total length of the curve
+	float length();
+	/* Curve parameter at a distance along the curve, from the arc-length table
+	 * distance - world units from the start (clamped to the curve)
+	 */
+	float paramAtDistance(float distance);
+	/* Point at a distance along the curve, so equal steps in distance move at constant speed
+	 * distance - world units from the start (clamped to the curve)
+	 */
+	glm::vec3 pointAtDistance(float distance);
+
+	/* Evaluate positions and tangents of many points at once (SSE/AVX when the compiler targets it)
+	 * params - curve parameter of each point, in [0, 1]
+	 * count - number of points
+	 * out - resized to count and filled (out.t is set to params)
+	 * use_simd - false forces the scalar path (for comparison)
+	 */
+	void evaluateBatch(const float * params, unsigned int count, CurveSamples & out, bool use_simd = true);
+	/* Evaluate many points given by distance along the curve (constant speed, like pointAtDistance)
+	 * distances - world units from the start of each point
+	 * count - number of points
+	 * out - resized to count and filled
+	 */
+	void evaluateBatchAtDistances(const float * distances, unsigned int count, CurveSamples & out);
+	// Width of the SIMD path compiled in (1 when only the scalar path is available)
+	static unsigned int simdWidth();
+#ifndef DEDICATED_SERVER
 	/* Curve render function
-	 * shaderProgram - glsl shader ID
-	 * P - Projection matrix
-	 * V - view matrix
+	 * context - render state of the pass (shader reads the projection and view from the Frame block)
 	 */
-	void draw(GLint shaderProgram, glm::mat4 P, glm::mat4 V);
+	void draw(const RenderContext & context);
+#endif
 };
\ No newline at end of file
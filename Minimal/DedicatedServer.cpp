@@ -0,0 +1,444 @@
+/* Headless dedicated server. Runs the authoritative GameLogic on a fixed timestep for two remote
+ * players with no GL/OVR/AL dependency (build with DEDICATED_SERVER defined)
+ *
+ * Usage: DedicatedServer [--cpu N] [--tick-rate HZ] [--bench]
+ *	--cpu N - pin the simulation thread to core N
+ *	--tick-rate HZ - simulation ticks per second (default SIM_TICK_RATE)
+ *	--bench - run the microbenchmarks (curves, collision, broad phase, snapshot size) on this core and exit instead of
+ *		serving. Exits with 1 if a size check fails
+ *
+ * The Bench configuration (or -DBENCH_ALLOCATIONS=ON with CMake) defines BENCH_ALLOCATIONS so --bench
+ * counts heap allocations (replaces the global operator new)
+ */
+#include "stdafx.h"
+#include "ServerGame.h"
+#include "GameLogic.h"
+#include "BroadPhase.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Print the average/worst tick cost every few seconds
+#define TICK_REPORT_SECONDS 5
+
+// Enemies evaluated per batch and the number of batches timed by --bench
+#define BENCH_CURVE_POINTS 4096
+#define BENCH_CURVE_ROUNDS 2000
+// Hitbox update + overlap tests timed by --bench
+#define BENCH_COLLISION_ROUNDS 10000000
+// Enemies, ticks and the big query batch for the broad phase benchmark
+#define BENCH_BROAD_PHASE_ENEMIES 512
+#define BENCH_BROAD_PHASE_TICKS 2000
+#define BENCH_BROAD_PHASE_QUERIES 64
+// Moving enemies and ticks for the snapshot size check, and how many bytes a delta may grow from the fewest to the most enemies
+#define BENCH_SNAPSHOT_ENEMIES_MIN 16
+#define BENCH_SNAPSHOT_ENEMIES_MAX 512
+#define BENCH_SNAPSHOT_TICKS 120
+#define BENCH_SNAPSHOT_SLACK 2.0
+
+using glm::mat4;
+
+#ifdef BENCH_ALLOCATIONS
+/* Every heap allocation in the process, so --bench can show which paths never allocate
+ * Replacing the global operators affects the whole server, so only bench builds define BENCH_ALLOCATIONS
+ */
+static std::atomic<size_t> heap_allocations(0);
+
+static void * countedAlloc(size_t size) {
+	heap_allocations++;
+	void * memory = malloc(size ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void * operator new(size_t size) { return countedAlloc(size); }
+void * operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void * memory) noexcept { free(memory); }
+void operator delete[](void * memory) noexcept { free(memory); }
+void operator delete(void * memory, size_t) noexcept { free(memory); }
+void operator delete[](void * memory, size_t) noexcept { free(memory); }
+
+#ifdef __cpp_aligned_new
+static void * countedAlignedAlloc(size_t size, std::align_val_t alignment) {
+	heap_allocations++;
+	size_t align = (size_t)alignment;
+	// aligned_alloc wants a multiple of the alignment
+	size = ((size ? size : 1) + align - 1) / align * align;
+#ifdef _WIN32
+	void * memory = _aligned_malloc(size, align);
+#else
+	void * memory = aligned_alloc(align, size);
+#endif
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+static void alignedFree(void * memory) {
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void * operator new(size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void * operator new[](size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void operator delete(void * memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void * memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void * memory, size_t, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void * memory, size_t, std::align_val_t) noexcept { alignedFree(memory); }
+#endif
+#endif
+
+/*------------------ HELPER FUNCTIONS -----------------*/
+bool pinToCore(int core) {
+#ifdef _WIN32
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#else
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#endif
+}
+
+/* Time batch Bezier evaluation of one path
+ * checksum - sum of sampled points, reported so the loop is not optimized away (scalar and simd should agree)
+ * returns millions of points (position and tangent) per second
+ */
+double benchCurveBatch(Curve * path, bool use_simd, float & checksum) {
+	std::vector<float> params(BENCH_CURVE_POINTS);
+	for (unsigned int i = 0; i < BENCH_CURVE_POINTS; i++) {
+		params[i] = (float)i / (BENCH_CURVE_POINTS - 1);
+	}
+	CurveSamples samples;
+	checksum = 0.0f;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int round = 0; round < BENCH_CURVE_ROUNDS; round++) {
+		path->evaluateBatch(params.data(), BENCH_CURVE_POINTS, samples, use_simd);
+		checksum += samples.x[round % BENCH_CURVE_POINTS];
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return (double)BENCH_CURVE_POINTS * BENCH_CURVE_ROUNDS / seconds / 1000000.0;
+}
+
+/* Time the hit detection done per enemy per tick: move the enemy box along a path and test it against a sword
+ * allocations - heap allocations made by the timed loop (0 unless built with BENCH_ALLOCATIONS)
+ * hits - collisions found, reported so the loop is not optimized away
+ * returns nanoseconds per update + test
+ */
+double benchCollision(GameLogic * logic, unsigned long long & allocations, unsigned int & hits) {
+	Bound * sword = GameLogic::createSwordBox(glm::vec3(0.1f, 1.0f, 0.1f));
+	Bound enemy(0.5f, 0.5f, 0.5f);
+	Curve * path = logic->path_container[0];
+	sword->update(glm::translate(mat4(1.0f), path->pointAtDistance(path->length() * 0.5f)));
+	hits = 0;
+
+#ifdef BENCH_ALLOCATIONS
+	size_t allocations_before = heap_allocations;
+#endif
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int round = 0; round < BENCH_COLLISION_ROUNDS; round++) {
+		glm::vec3 position(0.0f, 0.0f, -10.0f + 11.0f * (round & 1023) / 1023.0f);
+		enemy.update(glm::translate(mat4(1.0f), position));
+		hits += sword->check_collision(&enemy);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#ifdef BENCH_ALLOCATIONS
+	allocations = heap_allocations - allocations_before;
+#else
+	allocations = 0;
+#endif
+
+	delete sword;
+	return seconds * 1000000000.0 / BENCH_COLLISION_ROUNDS;
+}
+
+/* Time the SAT test on its own, for a sword and an enemy in the ambiguous region (AABBs overlap, boxes may not)
+ * returns nanoseconds per pair
+ */
+double benchObbPair(unsigned int & hits) {
+	Bound * sword = GameLogic::createSwordBox(glm::vec3(0.1f, 1.0f, 0.1f));
+	Bound enemy(0.5f, 0.5f, 0.5f);
+	sword->update(glm::rotate(mat4(1.0f), 0.8f, glm::vec3(0.0f, 0.0f, 1.0f)));
+	hits = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int round = 0; round < BENCH_COLLISION_ROUNDS; round++) {
+		// Nudge the box so every round is a fresh test
+		enemy.oriented_box.center[0] = (round & 255) / 512.0f;
+		hits += obbOverlap(sword->oriented_box, enemy.oriented_box);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	delete sword;
+	return seconds * 1000000000.0 / BENCH_COLLISION_ROUNDS;
+}
+
+// Box for the broad phase benchmark: a cube of a given size spread over the play area by a hash of its index
+AABB benchBox(unsigned int index, float half_size) {
+	float x = (float)((index * 7919) % 400) / 20.0f - 10.0f;
+	float z = (float)((index * 104729) % 400) / 20.0f - 10.0f;
+	float y = (float)(index % 4);
+	AABB box = { { x - half_size, y - half_size, z - half_size }, { x + half_size, y + half_size, z + half_size } };
+	return box;
+}
+
+/* Time a tick of candidate search between query boxes and many enemies drifting each tick, through the
+ * BroadPhase or by testing every pair
+ * query_count - query boxes (NUM_PLAYERS for the swords)
+ * use_broad_phase - go through BroadPhase, which builds its grid for big enough batches
+ * candidates - total pairs found over every tick
+ * returns microseconds per tick
+ */
+double benchBroadPhase(unsigned int query_count, bool use_broad_phase, unsigned int & candidates) {
+	BroadPhase broad_phase;
+	std::vector<AABB> spawn_boxes(BENCH_BROAD_PHASE_ENEMIES);
+	std::vector<AABB> enemies(BENCH_BROAD_PHASE_ENEMIES);
+	std::vector<unsigned int> ids(BENCH_BROAD_PHASE_ENEMIES);
+	std::vector<AABB> queries(query_count);
+	std::vector<BroadPhasePair> pairs;
+	for (unsigned int i = 0; i < BENCH_BROAD_PHASE_ENEMIES; i++) {
+		spawn_boxes[i] = benchBox(i, 0.25f);
+		ids[i] = i;
+	}
+	// Offset from the enemies' hash so queries don't sit right on top of them
+	for (unsigned int q = 0; q < query_count; q++) {
+		queries[q] = benchBox(q * 37 + 11, 0.5f);
+	}
+	candidates = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int tick = 0; tick < BENCH_BROAD_PHASE_TICKS; tick++) {
+		float drift = tick * 0.001f;
+		for (unsigned int i = 0; i < BENCH_BROAD_PHASE_ENEMIES; i++) {
+			enemies[i] = spawn_boxes[i];
+			enemies[i].min[0] += drift;
+			enemies[i].max[0] += drift;
+		}
+		if (use_broad_phase) {
+			broad_phase.queryPairs(enemies.data(), ids.data(), BENCH_BROAD_PHASE_ENEMIES, queries.data(), query_count, pairs);
+			candidates += (unsigned int)pairs.size();
+		}
+		else {
+			for (unsigned int q = 0; q < query_count; q++) {
+				for (unsigned int i = 0; i < BENCH_BROAD_PHASE_ENEMIES; i++) {
+					candidates += aabbOverlap(queries[q], enemies[i]);
+				}
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return seconds * 1000000.0 / BENCH_BROAD_PHASE_TICKS;
+}
+
+/* Average size of the per-tick snapshot delta with a number of enemies walking their paths, each delta
+ * against the previous tick's snapshot (a client that acks everything right away)
+ * returns bytes per delta
+ */
+double benchSnapshotDelta(unsigned int enemy_count) {
+	GameLogic logic(glm::vec3(0.1f, 1.0f, 0.1f), glm::vec3(0.5f), SIM_TICK_RATE);
+	// Swords far away from every path, so nothing gets killed
+	mat4 hand_transforms[NUM_PLAYERS];
+	for (unsigned int p = 0; p < NUM_PLAYERS; p++) {
+		hand_transforms[p] = glm::translate(mat4(1.0f), glm::vec3(0.0f, -100.0f, 0.0f));
+	}
+	logic.startTimer();
+	logic.start_game = true;
+	for (unsigned int i = 0; i < enemy_count; i++) {
+		logic.enemies.spawn((unsigned char)(i % NUM_ENEMY_PATHS), 0.5f + 0.01f * (i % 64));
+	}
+
+	// The first tick spawns the wave file's opening enemies, and the first snapshot carries everything
+	logic.tick(logic.tickLength(), hand_transforms);
+	WorldSnapshot baseline;
+	baseline.sequence = 1;
+	logic.fillSnapshot(baseline);
+
+	size_t bytes = 0;
+	std::vector<char> data;
+	for (unsigned int tick = 0; tick < BENCH_SNAPSHOT_TICKS; tick++) {
+		logic.tick(logic.tickLength(), hand_transforms);
+		WorldSnapshot snapshot;
+		snapshot.sequence = (unsigned short)(baseline.sequence + 1);
+		logic.fillSnapshot(snapshot);
+		data.clear();
+		snapshot.writeDelta(&baseline, -1, data);
+		bytes += data.size();
+		baseline = snapshot;
+	}
+	return (double)bytes / BENCH_SNAPSHOT_TICKS;
+}
+
+/* Run every benchmark and print the results
+ * returns false if a size check failed
+ */
+bool runBenchmarks(GameLogic * logic) {
+	Curve * path = logic->path_container[0];
+	float scalar_checksum = 0.0f;
+	float simd_checksum = 0.0f;
+	double scalar = benchCurveBatch(path, false, scalar_checksum);
+	double simd = benchCurveBatch(path, true, simd_checksum);
+	printf("curve batch: scalar %.1f Mpts/s, simd (width %u) %.1f Mpts/s, %.2fx (checksums %.3f, %.3f)\n",
+		scalar, Curve::simdWidth(), simd, simd / scalar, scalar_checksum, simd_checksum);
+
+	unsigned long long allocations = 0;
+	unsigned int collision_hits = 0;
+	double collision_ns = benchCollision(logic, allocations, collision_hits);
+#ifdef BENCH_ALLOCATIONS
+	printf("hitbox update + test: %.1f ns (%u hits), %llu heap allocations in %u rounds\n",
+		collision_ns, collision_hits, allocations, BENCH_COLLISION_ROUNDS);
+#else
+	printf("hitbox update + test: %.1f ns (%u hits), heap allocations not counted (use the Bench configuration)\n",
+		collision_ns, collision_hits);
+#endif
+
+	unsigned int hits = 0;
+	double obb_ns = benchObbPair(hits);
+	printf("obb sat pair: %.1f ns (%u hits)\n", obb_ns, hits);
+
+	// The swords are fewer than BROAD_PHASE_GRID_MIN_QUERIES, so the broad phase should cost the same as all pairs
+	// there, and the grid should win for the big batch
+	unsigned int query_counts[2] = { NUM_PLAYERS, BENCH_BROAD_PHASE_QUERIES };
+	for (unsigned int run = 0; run < 2; run++) {
+		unsigned int broad_candidates = 0;
+		unsigned int brute_candidates = 0;
+		double broad_us = benchBroadPhase(query_counts[run], true, broad_candidates);
+		double brute_us = benchBroadPhase(query_counts[run], false, brute_candidates);
+		printf("broad phase, %u enemies x %u boxes: %s %.2f us/tick, all pairs %.2f us/tick (%u vs %u candidates)\n",
+			BENCH_BROAD_PHASE_ENEMIES, query_counts[run], query_counts[run] >= BROAD_PHASE_GRID_MIN_QUERIES ? "grid" : "scan",
+			broad_us, brute_us, broad_candidates, brute_candidates);
+	}
+
+	// Enemies are extrapolated on the client, so walking them must not cost bandwidth
+	double few_bytes = benchSnapshotDelta(BENCH_SNAPSHOT_ENEMIES_MIN);
+	double many_bytes = benchSnapshotDelta(BENCH_SNAPSHOT_ENEMIES_MAX);
+	bool flat = many_bytes <= few_bytes + BENCH_SNAPSHOT_SLACK;
+	printf("snapshot delta: %u moving enemies %.1f B/tick, %u moving enemies %.1f B/tick (%s)\n",
+		BENCH_SNAPSHOT_ENEMIES_MIN, few_bytes, BENCH_SNAPSHOT_ENEMIES_MAX, many_bytes, flat ? "flat" : "FAIL: grows with enemies");
+	return flat;
+}
+
+// Send each player the world state (enemies, HP, score and the other player's pose)
+void sendWorldState(ServerGame * server, GameLogic * logic) {
+	WorldSnapshot snapshot;
+	logic->fillSnapshot(snapshot);
+
+	for (unsigned int p = 0; p < server->players.size() && p < NUM_PLAYERS; p++) {
+		unsigned int client = server->players[p];
+		PlayerState player = { (unsigned char)p, server->clientHandTransforms[client], server->clientHeadTransforms[client], server->clientPoseTimes[client] };
+		snapshot.players.push_back(player);
+	}
+	server->sendSnapshots(snapshot, 0);
+}
+
+int main(int argc, char** argv) {
+	int tick_rate = SIM_TICK_RATE;
+	bool bench = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+			int core = atoi(argv[++i]);
+			if (!pinToCore(core)) {
+				std::cerr << "Could not pin the simulation to core " << core << std::endl;
+			}
+		}
+		else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+			tick_rate = atoi(argv[++i]);
+			if (tick_rate <= 0) {
+				std::cerr << "Invalid tick rate, using " << SIM_TICK_RATE << std::endl;
+				tick_rate = SIM_TICK_RATE;
+			}
+		}
+		else if (strcmp(argv[i], "--bench") == 0) {
+			bench = true;
+		}
+	}
+
+	// Size the hitboxes from the same models the clients draw
+	GameLogic logic(GameLogic::objBoxDimensions(SWORD_MODEL_PATH, SWORD_SCALE),
+					GameLogic::objBoxDimensions(ENEMY_MODEL_PATH, ENEMY_SCALE), tick_rate);
+	if (bench) {
+		return runBenchmarks(&logic) ? 0 : 1;
+	}
+	ServerGame server(NUM_PLAYERS);
+	std::cout << "Dedicated server running at " << tick_rate << " ticks per second" << std::endl;
+
+	const std::chrono::nanoseconds tick_length(1000000000LL / tick_rate);
+	const unsigned long long report_interval = (unsigned long long)tick_rate * TICK_REPORT_SECONDS;
+	std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+	double tick_total_us = 0.0;
+	double tick_worst_us = 0.0;
+	unsigned long long ticks = 0;
+	unsigned long long reported_bytes = 0;
+
+	while (true) {
+		// Service the sockets until the tick is due instead of sleeping, so input is read as it arrives
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		do {
+			int wait_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(next_tick - now).count();
+			server.update(wait_ms > 0 ? wait_ms : 0);
+			now = std::chrono::steady_clock::now();
+		} while (now < next_tick);
+
+		std::chrono::steady_clock::time_point tick_start = now;
+
+		if (server.player2Found) {
+			logic.startTimer();
+
+			mat4 hand_transforms[NUM_PLAYERS];
+			for (unsigned int p = 0; p < NUM_PLAYERS; p++) {
+				hand_transforms[p] = server.clientHandTransforms[server.players[p]];
+			}
+			logic.tick(logic.tickLength(), hand_transforms);
+
+			sendWorldState(&server, &logic);
+		}
+		// One batched write per client per tick
+		server.flushPackets();
+
+		// Measure the cost of the tick in isolation from the network wait
+		double tick_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tick_start).count();
+		tick_total_us += tick_us;
+		if (tick_us > tick_worst_us) {
+			tick_worst_us = tick_us;
+		}
+		if (++ticks % report_interval == 0) {
+			// Outgoing bandwidth per connected player over the report interval
+			double seconds = (double)TICK_REPORT_SECONDS;
+			unsigned int players = server.players.size() > 0 ? (unsigned int)server.players.size() : 1;
+			double bytes_per_player = (double)(server.bytesSent() - reported_bytes) / players / seconds;
+			reported_bytes = server.bytesSent();
+
+			printf("tick cost: avg %.1f us, worst %.1f us, out %.2f KB/s per player\n",
+				tick_total_us / report_interval, tick_worst_us, bytes_per_player / 1024.0);
+			tick_total_us = 0.0;
+			tick_worst_us = 0.0;
+		}
+
+		// Fixed timestep. If we fell behind, skip ahead instead of bursting ticks
+		next_tick += tick_length;
+		now = std::chrono::steady_clock::now();
+		if (next_tick < now) {
+			next_tick = now;
+		}
+	}
+
+	return 0;
+}
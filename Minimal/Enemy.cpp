@@ -41,15 +41,23 @@ Bound * Enemy::getHitBox() {
 	return hitbox;
 }
 
+vec3 Enemy::getHitBoxSize() {
+	return box_size;
+}
+
 void Enemy::initialize_hitbox() {
-	vec3 box_size = glm::scale(mat4(1.0f), vec3(scale_factor)) * vec4(enemy->getBoxDimensions(), 1.0f);
+	box_size = glm::scale(mat4(1.0f), vec3(scale_factor)) * vec4(enemy->getBoxDimensions(), 1.0f);
 	hitbox = new Bound(box_size.x / 4.0f, box_size.y / 4.0f, box_size.z / 4.0f);
 }
 
-void Enemy::draw(Shader shader, mat4 P, mat4 V, mat4 C) {
-	enemy->draw(shader, P, V, C);
+void Enemy::draw(RenderContext & context) {
+	enemy->draw(context);
+}
+
+void Enemy::drawInstanced(const RenderContext & context, const std::vector<mat4> & transforms) {
+	enemy->drawInstanced(context, transforms);
 }
 
-void Enemy::drawHitBox(Shader shader, mat4 P, mat4 V, mat4 C) {
-	hitbox->draw(shader.ID, P, V, C);
+void Enemy::drawHitBox(const RenderContext & context) {
+	hitbox->draw(context);
 }
\ No newline at end of file
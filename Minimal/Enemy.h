@@ -40,12 +40,14 @@ public:
 	~Enemy();
 
 	/* Render function for enemy
-	 * shader - glsl shader for rasterization and other gfx
-	 * P - projection matrix
-	 * V - view matrix
-	 * C - transformation matrix
+	 * context - render state of the pass (shader, and the enemy's transformation on top of the transform stack)
 	 */
-	void draw(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C);
+	void draw(RenderContext & context);
+	/* Render many enemies at once (one draw call per mesh of the model)
+	 * context - render state of the pass (the shader needs a per-instance model matrix, enemy_instanced.vert)
+	 * transforms - transformation matrix of each enemy
+	 */
+	void drawInstanced(const RenderContext & context, const std::vector<glm::mat4> & transforms);
 	// Does not do anything
 	void update();
 	/* Update hit box by calling hitbox's update method
@@ -54,18 +56,18 @@ public:
 	void updateHitBox(glm::mat4 transform_mat);
 	// Hitbox getter method
 	Bound * getHitBox();
+	// Dimensions of the scaled enemy model (what the hitbox is built from)
+	glm::vec3 getHitBoxSize();
 	/* Hitbox render method.
-	 * shader - glsl shader
-	 * P - projection matrix
-	 * V - view matrix
-	 * C - transformation matrix
+	 * context - render state of the pass (bounds shader, and the enemy's transformation on top of the transform stack)
 	 */
-	void drawHitBox(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C);
+	void drawHitBox(const RenderContext & context);
 
 private:
 	/* Private Data */
 	unsigned int enemyType;
 	float scale_factor;
+	glm::vec3 box_size;
 	Model * enemy;
 	Bound * hitbox;
 
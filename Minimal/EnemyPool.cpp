@@ -0,0 +1,105 @@
+#include "EnemyPool.h"
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+EnemyPool::EnemyPool() {
+	// Everything is sized once here. live and free_slots never grow past MAX_ENEMIES
+	ids.resize(MAX_ENEMIES);
+	paths.resize(MAX_ENEMIES);
+	types.resize(MAX_ENEMIES);
+	speeds.resize(MAX_ENEMIES);
+	distances.resize(MAX_ENEMIES);
+	prev_distances.resize(MAX_ENEMIES);
+	hp.resize(MAX_ENEMIES);
+	boxes.resize(MAX_ENEMIES);
+	oriented_boxes.resize(MAX_ENEMIES);
+	alive.resize(MAX_ENEMIES);
+	generations.resize(MAX_ENEMIES);
+	list_index.resize(MAX_ENEMIES);
+	live.reserve(MAX_ENEMIES);
+	free_slots.reserve(MAX_ENEMIES);
+	clear();
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+void EnemyPool::claim(unsigned int slot) {
+	// Swap-remove from the free stack, then append to live
+	unsigned int moved = free_slots.back();
+	free_slots[list_index[slot]] = moved;
+	list_index[moved] = list_index[slot];
+	free_slots.pop_back();
+
+	alive[slot] = 1;
+	list_index[slot] = (unsigned int)live.size();
+	live.push_back(slot);
+}
+
+/*------------------------ PUBLIC FUNCTIONS ---------------------------*/
+unsigned int EnemyPool::spawn(unsigned char path, float speed, unsigned char type) {
+	if (free_slots.empty()) {
+		return ENEMY_NONE;
+	}
+	unsigned int slot = free_slots.back();
+	claim(slot);
+
+	generations[slot]++;
+	ids[slot] = (unsigned short)((generations[slot] << ENEMY_SLOT_BITS) | slot);
+	paths[slot] = path;
+	types[slot] = type;
+	speeds[slot] = speed;
+	distances[slot] = 0.0f;
+	prev_distances[slot] = 0.0f;
+	hp[slot] = ENEMY_HP;
+	return slot;
+}
+
+unsigned int EnemyPool::spawnWithId(unsigned short id, unsigned char path, float speed, unsigned char type, float distance) {
+	unsigned int slot = id & (MAX_ENEMIES - 1);
+	if (alive[slot]) {
+		despawn(slot);
+	}
+	claim(slot);
+
+	generations[slot] = (unsigned short)(id >> ENEMY_SLOT_BITS);
+	ids[slot] = id;
+	paths[slot] = path;
+	types[slot] = type;
+	speeds[slot] = speed;
+	distances[slot] = distance;
+	prev_distances[slot] = distance;
+	hp[slot] = ENEMY_HP;
+	return slot;
+}
+
+void EnemyPool::despawn(unsigned int slot) {
+	if (slot >= MAX_ENEMIES || !alive[slot]) {
+		return;
+	}
+	unsigned int moved = live.back();
+	live[list_index[slot]] = moved;
+	list_index[moved] = list_index[slot];
+	live.pop_back();
+
+	alive[slot] = 0;
+	list_index[slot] = (unsigned int)free_slots.size();
+	free_slots.push_back(slot);
+}
+
+void EnemyPool::clear() {
+	live.clear();
+	free_slots.clear();
+	// Pushed in reverse so slot 0 is handed out first
+	for (unsigned int slot = MAX_ENEMIES; slot-- > 0;) {
+		alive[slot] = 0;
+		list_index[slot] = (unsigned int)free_slots.size();
+		free_slots.push_back(slot);
+	}
+}
+
+unsigned int EnemyPool::slotOf(unsigned short id) {
+	unsigned int slot = id & (MAX_ENEMIES - 1);
+	return alive[slot] && ids[slot] == id ? slot : ENEMY_NONE;
+}
+
+unsigned int EnemyPool::count() {
+	return (unsigned int)live.size();
+}
@@ -0,0 +1,70 @@
+/* Preallocated pool of live enemies, stored as parallel arrays (SoA) indexed by slot
+ * Spawning pops a slot off the free list and despawning pushes it back, so neither touches the heap.
+ * live lists the occupied slots densely, for tight loops over just the enemies that exist.
+ * Each spawn gets an id made of the slot and a generation count, so a reused slot gets a new id.
+ */
+#pragma once
+#ifndef _ENEMY_POOL_H_
+#define _ENEMY_POOL_H_
+
+#include "Bound.h"
+#include <vector>
+
+// Slots in the pool. Ids keep the slot in their low ENEMY_SLOT_BITS and a generation above it
+#define ENEMY_SLOT_BITS 9
+#define MAX_ENEMIES (1 << ENEMY_SLOT_BITS)
+// Hits an enemy takes before it dies
+#define ENEMY_HP 1
+// Returned by spawn/slotOf when there is no slot
+#define ENEMY_NONE 0xFFFFFFFFu
+
+class EnemyPool {
+public:
+	/* Enemy data, indexed by slot (only meaningful for slots in live) */
+	std::vector<unsigned short> ids;
+	std::vector<unsigned char> paths;		// Path the enemy walks
+	std::vector<unsigned char> types;		// Enemy type (which model and stats)
+	std::vector<float> speeds;				// World units per second along the path
+	std::vector<float> distances;			// Distance along the path
+	std::vector<float> prev_distances;		// Distance before the last tick (for render interpolation)
+	std::vector<short> hp;
+	std::vector<AABB> boxes;				// Hitbox from the last tick
+	std::vector<OBB> oriented_boxes;
+
+	std::vector<unsigned int> live;			// Occupied slots, densely packed (order changes on despawn)
+
+	EnemyPool();
+
+	/* Take a free slot for a new enemy at the start of a path
+	 * path - path it walks
+	 * speed - world units per second along the path
+	 * type - enemy type
+	 * returns the slot, or ENEMY_NONE if the pool is full
+	 */
+	unsigned int spawn(unsigned char path, float speed, unsigned char type = 0);
+	/* Take the slot named by an id received from the server, replacing whatever is there
+	 * Anything tracking slots outside the pool (GameLogic's broad phase) should despawn the old occupant first
+	 * returns the slot
+	 */
+	unsigned int spawnWithId(unsigned short id, unsigned char path, float speed, unsigned char type, float distance);
+	// Free a slot. Swaps the last live slot into its place in live
+	void despawn(unsigned int slot);
+	// Free every slot
+	void clear();
+
+	// Slot of a live enemy with the given id, or ENEMY_NONE
+	unsigned int slotOf(unsigned short id);
+	// Enemies alive
+	unsigned int count();
+
+private:
+	std::vector<unsigned int> free_slots;		// Stack of unused slots
+	std::vector<unsigned int> list_index;		// Position of each slot in live or free_slots
+	std::vector<unsigned char> alive;
+	std::vector<unsigned short> generations;	// Bumped on each spawn into a slot
+
+	// Take a specific slot off the free list
+	void claim(unsigned int slot);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "FrameBuffer.h"
+
+#define FRAME_BUFFER_MASK (FRAME_BUFFER_SIZE - 1)
+
+FrameBuffer::FrameBuffer()
+{
+    data = new char[FRAME_BUFFER_SIZE];
+    scratch = new char[MAX_FRAME_PAYLOAD];
+    read_pos = 0;
+    write_pos = 0;
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    delete[] data;
+    delete[] scratch;
+}
+
+unsigned int FrameBuffer::size()
+{
+    return write_pos - read_pos;
+}
+
+char * FrameBuffer::writePtr(unsigned int & space)
+{
+    unsigned int start = write_pos & FRAME_BUFFER_MASK;
+    unsigned int free_space = FRAME_BUFFER_SIZE - size();
+    unsigned int contiguous = FRAME_BUFFER_SIZE - start;
+
+    space = free_space < contiguous ? free_space : contiguous;
+    return data + start;
+}
+
+void FrameBuffer::commitWrite(unsigned int bytes)
+{
+    write_pos += bytes;
+}
+
+bool FrameBuffer::pushFrame(const char * payload, unsigned int length)
+{
+    if (length > MAX_FRAME_PAYLOAD || FRAME_BUFFER_SIZE - size() < FRAME_HEADER_SIZE + length) {
+        return false;
+    }
+
+    char header[FRAME_HEADER_SIZE];
+    writeFrameHeader(header, length);
+
+    // Header and payload may each wrap around the end of the ring
+    const char * parts[2] = { header, payload };
+    unsigned int sizes[2] = { FRAME_HEADER_SIZE, length };
+    for (unsigned int p = 0; p < 2; p++) {
+        unsigned int start = write_pos & FRAME_BUFFER_MASK;
+        unsigned int first = FRAME_BUFFER_SIZE - start;
+
+        if (sizes[p] <= first) {
+            memcpy(data + start, parts[p], sizes[p]);
+        }
+        else {
+            memcpy(data + start, parts[p], first);
+            memcpy(data, parts[p] + first, sizes[p] - first);
+        }
+        write_pos += sizes[p];
+    }
+    return true;
+}
+
+void FrameBuffer::peek(unsigned int offset, char * dest, unsigned int bytes)
+{
+    unsigned int start = (read_pos + offset) & FRAME_BUFFER_MASK;
+    unsigned int first = FRAME_BUFFER_SIZE - start;
+
+    if (bytes <= first) {
+        memcpy(dest, data + start, bytes);
+    }
+    else {
+        memcpy(dest, data + start, first);
+        memcpy(dest + first, data, bytes - first);
+    }
+}
+
+bool FrameBuffer::nextFrame(char *& payload, unsigned int & length)
+{
+    if (size() < FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    char header[FRAME_HEADER_SIZE];
+    peek(0, header, FRAME_HEADER_SIZE);
+    length = readFrameHeader(header);
+
+    // Wait for the rest of the frame
+    if (size() < FRAME_HEADER_SIZE + length) {
+        return false;
+    }
+
+    unsigned int start = (read_pos + FRAME_HEADER_SIZE) & FRAME_BUFFER_MASK;
+    if (start + length <= FRAME_BUFFER_SIZE) {
+        payload = data + start;
+    }
+    else {
+        peek(FRAME_HEADER_SIZE, scratch, length);
+        payload = scratch;
+    }
+
+    read_pos += FRAME_HEADER_SIZE + length;
+    return true;
+}
@@ -0,0 +1,50 @@
+/* Per-connection receive ring buffer that reassembles length-prefixed frames
+ * recv() writes straight into the ring and complete frames are handed out in place. Only a frame that
+ * straddles the end of the ring is copied (into a scratch buffer) so the caller always sees it contiguous
+ */
+#pragma once
+#include "NetworkData.h"
+
+// Must be a power of two and larger than the biggest frame
+#define FRAME_BUFFER_SIZE (1 << 17)
+
+class FrameBuffer
+{
+public:
+	FrameBuffer();
+	~FrameBuffer();
+	// Owns its storage, so it is never copied
+	FrameBuffer(const FrameBuffer &) = delete;
+	FrameBuffer & operator=(const FrameBuffer &) = delete;
+
+	/* Contiguous free space at the write end, for recv to fill directly
+	 * space - set to the number of bytes that can be written at the returned pointer (0 when full)
+	 */
+	char * writePtr(unsigned int & space);
+	// Mark bytes written at writePtr as received
+	void commitWrite(unsigned int bytes);
+
+	/* Copy in a whole frame (header added here), for messages that arrive in one piece like datagrams
+	 * returns false if there is no room for it
+	 */
+	bool pushFrame(const char * payload, unsigned int length);
+
+	/* Pop the next complete frame
+	 * payload - set to the frame's payload, valid until the next commitWrite
+	 * length - set to the payload length
+	 * returns false if no complete frame has arrived yet
+	 */
+	bool nextFrame(char *& payload, unsigned int & length);
+
+	// Bytes received but not yet consumed
+	unsigned int size();
+
+private:
+	char * data;
+	char * scratch;				// Holds a frame that wraps around the end of the ring
+	unsigned int read_pos;		// Positions only ever increase, the ring index is pos & (FRAME_BUFFER_SIZE - 1)
+	unsigned int write_pos;
+
+	// Copy bytes starting offset bytes after read_pos, handling the wrap
+	void peek(unsigned int offset, char * dest, unsigned int bytes);
+};
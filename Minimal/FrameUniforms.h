@@ -0,0 +1,57 @@
+/* Per-frame matrices shared by every shader through one uniform buffer (the "Frame" block)
+ * RiftApp::draw uploads the projection and view once per eye, or once per frame with single-pass
+ * stereo, so draws only set their own model matrix.
+ */
+#pragma once
+#ifndef _FRAME_UNIFORMS_H_
+#define _FRAME_UNIFORMS_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#include <glm/mat4x4.hpp>
+
+#include "Stereo.h"
+#include "GLState.h"
+
+#define FRAME_UNIFORM_BLOCK "Frame"		// Block name in the shaders
+#define FRAME_UNIFORM_BINDING 0			// Uniform buffer binding point it reads from
+
+// Mirrors the std140 layout of the Frame block (see obj_shader.vert)
+struct FrameUniforms {
+	glm::mat4 projection[STEREO_EYES];
+	glm::mat4 view[STEREO_EYES];
+	GLint stereo;						// Non-zero for single-pass stereo
+	GLint padding[3];
+};
+
+/* Upload the matrices of the pass about to be drawn to the shared buffer (created on first use)
+ * projection - projection matrix of each eye in the pass
+ * view - view matrix of each eye in the pass
+ * eyes - 1 for a pass per eye, STEREO_EYES for single-pass stereo
+ */
+inline void updateFrameUniforms(const glm::mat4 * projection, const glm::mat4 * view, unsigned int eyes) {
+	static GLuint buffer = 0;
+	if (buffer == 0) {
+		glGenBuffers(1, &buffer);
+		glState().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+		glState().bindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, buffer);
+	}
+
+	FrameUniforms frame = {};
+	for (unsigned int eye = 0; eye < eyes; eye++) {
+		frame.projection[eye] = projection[eye];
+		frame.view[eye] = view[eye];
+	}
+	frame.stereo = eyes > 1;
+
+	glState().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "Frustum.h"
+#include <glm/glm.hpp>
+#include <float.h>
+#include <math.h>
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+Frustum::Frustum() {
+	for (int i = 0; i < FRUSTUM_PLANES; i++) {
+		planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const glm::mat4 & m) {
+	// Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others
+	for (int i = 0; i < 3; i++) {
+		glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+		glm::vec4 w_row(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[2 * i] = w_row + row;
+		planes[2 * i + 1] = w_row - row;
+	}
+	for (int i = 0; i < FRUSTUM_PLANES; i++) {
+		float length = glm::length(glm::vec3(planes[i]));
+		planes[i] /= length;
+	}
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+void Frustum::corners(const glm::mat4 & view_projection, glm::vec3 * out) {
+	glm::mat4 inverse = glm::inverse(view_projection);
+	for (int i = 0; i < 8; i++) {
+		glm::vec4 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+		glm::vec4 world = inverse * ndc;
+		out[i] = glm::vec3(world) / world.w;
+	}
+}
+
+Frustum Frustum::combined(const glm::mat4 & left_view_projection, const glm::mat4 & right_view_projection) {
+	Frustum eyes[2] = { Frustum(left_view_projection), Frustum(right_view_projection) };
+	glm::vec3 points[16];
+	corners(left_view_projection, points);
+	corners(right_view_projection, points + 8);
+
+	// For each side, take one eye's plane and push it out until both eyes' corners are inside. The union of the
+	// eyes lies inside the hull of those corners. Keep whichever eye's plane had to move least
+	Frustum result;
+	for (int p = 0; p < FRUSTUM_PLANES; p++) {
+		float least_growth = FLT_MAX;
+		for (int e = 0; e < 2; e++) {
+			glm::vec3 normal(eyes[e].planes[p]);
+			float d = eyes[e].planes[p].w;
+			float needed = d;
+			for (int c = 0; c < 16; c++) {
+				needed = fmaxf(needed, -glm::dot(normal, points[c]));
+			}
+			if (needed - d < least_growth) {
+				least_growth = needed - d;
+				result.planes[p] = glm::vec4(normal, needed);
+			}
+		}
+	}
+	return result;
+}
+
+/*------------------------ CULLING TESTS ---------------------------*/
+bool Frustum::containsSphere(const glm::vec3 & center, float radius) const {
+	for (int i = 0; i < FRUSTUM_PLANES; i++) {
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::containsBox(const glm::vec3 & min, const glm::vec3 & max) const {
+	for (int i = 0; i < FRUSTUM_PLANES; i++) {
+		// The corner furthest along the plane normal is the last one to leave
+		glm::vec3 far_corner(planes[i].x > 0.0f ? max.x : min.x, planes[i].y > 0.0f ? max.y : min.y, planes[i].z > 0.0f ? max.z : min.z);
+		if (glm::dot(glm::vec3(planes[i]), far_corner) + planes[i].w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::containsBounds(const glm::mat4 & M, const glm::vec3 & local_min, const glm::vec3 & local_max,
+	const glm::vec3 & local_center, float local_radius) const {
+	// Sphere: center moves with M, radius grows with the largest scale
+	float scale = fmaxf(glm::length(glm::vec3(M[0])), fmaxf(glm::length(glm::vec3(M[1])), glm::length(glm::vec3(M[2]))));
+	if (!containsSphere(glm::vec3(M * glm::vec4(local_center, 1.0f)), local_radius * scale)) {
+		return false;
+	}
+
+	// Box: world AABB of the transformed box (Arvo), from its center and half extents
+	glm::vec3 center = glm::vec3(M * glm::vec4((local_min + local_max) * 0.5f, 1.0f));
+	glm::vec3 half = (local_max - local_min) * 0.5f;
+	glm::vec3 extent;
+	for (int i = 0; i < 3; i++) {
+		extent[i] = fabsf(M[0][i]) * half.x + fabsf(M[1][i]) * half.y + fabsf(M[2][i]) * half.z;
+	}
+	return containsBox(center - extent, center + extent);
+}
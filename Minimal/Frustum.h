@@ -0,0 +1,53 @@
+/* View frustum for culling, as six inward facing planes (n.p + d >= 0 inside)
+ * Built from a projection * view matrix, or from both eyes at once: the combined frustum contains both
+ * eye frusta, so single-pass stereo culls each object once for the pair of eyes.
+ */
+#pragma once
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+enum FrustumPlane { FRUSTUM_LEFT, FRUSTUM_RIGHT, FRUSTUM_BOTTOM, FRUSTUM_TOP, FRUSTUM_NEAR, FRUSTUM_FAR, FRUSTUM_PLANES };
+
+class Frustum {
+public:
+	glm::vec4 planes[FRUSTUM_PLANES];	// xyz - unit normal pointing inside, w - distance term
+
+	// Frustum that contains everything (nothing gets culled)
+	Frustum();
+	/* Frustum of a camera
+	 * view_projection - projection * view matrix (OpenGL clip range)
+	 */
+	Frustum(const glm::mat4 & view_projection);
+
+	/* One frustum containing both eyes' frusta
+	 * left_view_projection - projection * view of the left eye
+	 * right_view_projection - projection * view of the right eye
+	 */
+	static Frustum combined(const glm::mat4 & left_view_projection, const glm::mat4 & right_view_projection);
+
+	// True unless the sphere is entirely outside
+	bool containsSphere(const glm::vec3 & center, float radius) const;
+	// True unless the world space box is entirely outside
+	bool containsBox(const glm::vec3 & min, const glm::vec3 & max) const;
+	/* True unless local bounds placed with a model matrix are entirely outside. The sphere rejects first, the box is tighter
+	 * M - model matrix
+	 * local_min, local_max - local space box
+	 * local_center, local_radius - local space bounding sphere
+	 */
+	bool containsBounds(const glm::mat4 & M, const glm::vec3 & local_min, const glm::vec3 & local_max,
+		const glm::vec3 & local_center, float local_radius) const;
+
+private:
+	// The 8 world space corners of a camera's frustum
+	static void corners(const glm::mat4 & view_projection, glm::vec3 * out);
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "GLState.h"
+
+// Tracked value that matches no real one, so the next call always goes through
+#define UNKNOWN_STATE 0xFFFFFFFF
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+GLState::GLState() {
+	invalidate();
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+static int bufferSlot(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER: return STATE_ARRAY_BUFFER;
+	case GL_ELEMENT_ARRAY_BUFFER: return STATE_ELEMENT_ARRAY_BUFFER;
+	case GL_UNIFORM_BUFFER: return STATE_UNIFORM_BUFFER;
+	case GL_DRAW_INDIRECT_BUFFER: return STATE_DRAW_INDIRECT_BUFFER;
+	case GL_COPY_READ_BUFFER: return STATE_COPY_READ_BUFFER;
+	case GL_COPY_WRITE_BUFFER: return STATE_COPY_WRITE_BUFFER;
+	}
+	return -1;
+}
+
+static int textureSlot(GLenum target) {
+	switch (target) {
+	case GL_TEXTURE_2D: return STATE_TEXTURE_2D;
+	case GL_TEXTURE_CUBE_MAP: return STATE_TEXTURE_CUBE_MAP;
+	}
+	return -1;
+}
+
+void GLState::invalidate() {
+	program = UNKNOWN_STATE;
+	vao = UNKNOWN_STATE;
+	for (int i = 0; i < NUM_STATE_BUFFERS; i++) {
+		buffers[i] = UNKNOWN_STATE;
+	}
+	for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+		for (int i = 0; i < NUM_STATE_TEXTURES; i++) {
+			textures[unit][i] = UNKNOWN_STATE;
+		}
+	}
+	active_unit = UNKNOWN_STATE;
+	cull_face = -1;
+	front_face = UNKNOWN_STATE;
+	polygon_mode = UNKNOWN_STATE;
+}
+
+/*------------------------ BINDINGS ---------------------------*/
+void GLState::useProgram(GLuint next) {
+	if (next == program) {
+		skipped++;
+		return;
+	}
+	glUseProgram(next);
+	program = next;
+}
+
+void GLState::bindVertexArray(GLuint next) {
+	if (next == vao) {
+		skipped++;
+		return;
+	}
+	glBindVertexArray(next);
+	vao = next;
+	// The element array binding belongs to the vertex array
+	buffers[STATE_ELEMENT_ARRAY_BUFFER] = UNKNOWN_STATE;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+	int slot = bufferSlot(target);
+	if (slot >= 0 && buffers[slot] == buffer) {
+		skipped++;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (slot >= 0) {
+		buffers[slot] = buffer;
+	}
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	glBindBufferBase(target, index, buffer);
+	int slot = bufferSlot(target);
+	if (slot >= 0) {
+		buffers[slot] = buffer;
+	}
+}
+
+void GLState::activeTexture(unsigned int unit) {
+	if (unit == active_unit) {
+		skipped++;
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + unit);
+	active_unit = unit;
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+	int slot = textureSlot(target);
+	if (unit >= GL_STATE_TEXTURE_UNITS || slot < 0) {
+		activeTexture(unit);
+		glBindTexture(target, texture);
+		return;
+	}
+	if (textures[unit][slot] == texture) {
+		skipped++;
+		return;
+	}
+	activeTexture(unit);
+	glBindTexture(target, texture);
+	textures[unit][slot] = texture;
+}
+
+/*------------------------ FIXED FUNCTION STATE ---------------------------*/
+void GLState::cullFace(bool enabled) {
+	if (cull_face == (enabled ? 1 : 0)) {
+		skipped++;
+		return;
+	}
+	if (enabled) {
+		glEnable(GL_CULL_FACE);
+	}
+	else {
+		glDisable(GL_CULL_FACE);
+	}
+	cull_face = enabled ? 1 : 0;
+}
+
+void GLState::frontFace(GLenum mode) {
+	if (mode == front_face) {
+		skipped++;
+		return;
+	}
+	glFrontFace(mode);
+	front_face = mode;
+}
+
+void GLState::polygonMode(GLenum mode) {
+	if (mode == polygon_mode) {
+		skipped++;
+		return;
+	}
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+	polygon_mode = mode;
+}
+
+/*------------------------ DELETED OBJECTS ---------------------------*/
+void GLState::deletedVertexArray(GLuint name) {
+	if (vao == name) {
+		vao = 0;
+		buffers[STATE_ELEMENT_ARRAY_BUFFER] = UNKNOWN_STATE;
+	}
+}
+
+void GLState::deletedBuffer(GLuint name) {
+	for (int i = 0; i < NUM_STATE_BUFFERS; i++) {
+		if (buffers[i] == name) {
+			buffers[i] = 0;
+		}
+	}
+}
+
+void GLState::deletedTexture(GLuint name) {
+	for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+		for (int i = 0; i < NUM_STATE_TEXTURES; i++) {
+			if (textures[unit][i] == name) {
+				textures[unit][i] = 0;
+			}
+		}
+	}
+}
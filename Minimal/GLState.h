@@ -0,0 +1,81 @@
+/* Shadow copy of the GL state the renderer touches
+ * Every bind of a program, vertex array, buffer or texture, and every face culling / polygon mode change
+ * goes through glState(). Calls that would set what is already set are skipped (and counted), so draw
+ * paths can simply bind what they need without unbinding afterwards.
+ * Anything changing the same state behind its back must call invalidate() afterwards.
+ */
+#pragma once
+#ifndef _GL_STATE_H_
+#define _GL_STATE_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+// Texture units tracked (units past this are bound without checking)
+#define GL_STATE_TEXTURE_UNITS 16
+
+enum GLStateBuffer { STATE_ARRAY_BUFFER, STATE_ELEMENT_ARRAY_BUFFER, STATE_UNIFORM_BUFFER, STATE_DRAW_INDIRECT_BUFFER,
+					 STATE_COPY_READ_BUFFER, STATE_COPY_WRITE_BUFFER, NUM_STATE_BUFFERS };
+enum GLStateTexture { STATE_TEXTURE_2D, STATE_TEXTURE_CUBE_MAP, NUM_STATE_TEXTURES };
+
+class GLState {
+public:
+	unsigned int skipped = 0;	// Calls skipped since it was last reset
+
+	GLState();
+
+	// Forget everything tracked, the next call of each kind goes to GL
+	void invalidate();
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+	/* Bind a buffer to a target (array, element array, uniform, draw indirect and copy buffers are tracked)
+	 * target - GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, ...
+	 * buffer - buffer name, 0 to unbind
+	 */
+	void bindBuffer(GLenum target, GLuint buffer);
+	// glBindBufferBase, which also binds the buffer to the target's general binding point
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	/* Bind a texture to a texture unit, switching the active unit only if the binding changes
+	 * unit - texture unit number (0 for GL_TEXTURE0)
+	 * target - GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP (others are bound without checking)
+	 * texture - texture name, 0 to unbind
+	 */
+	void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+	// Make a texture unit active (unit number, 0 for GL_TEXTURE0)
+	void activeTexture(unsigned int unit);
+	void cullFace(bool enabled);
+	void frontFace(GLenum mode);
+	// Polygon mode of both faces (GL_FILL, GL_LINE)
+	void polygonMode(GLenum mode);
+
+	/* Forget deleted objects (GL unbinds them), so a new object given a recycled name still gets bound
+	 * vao, buffer, texture - deleted name
+	 */
+	void deletedVertexArray(GLuint vao);
+	void deletedBuffer(GLuint buffer);
+	void deletedTexture(GLuint texture);
+
+private:
+	GLuint program;
+	GLuint vao;
+	GLuint buffers[NUM_STATE_BUFFERS];
+	GLuint textures[GL_STATE_TEXTURE_UNITS][NUM_STATE_TEXTURES];
+	GLuint active_unit;
+	GLint cull_face;
+	GLenum front_face;
+	GLenum polygon_mode;
+};
+
+// The GL state of the (only) context
+inline GLState & glState() {
+	static GLState state;
+	return state;
+}
+
+#endif
@@ -0,0 +1,366 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include "GameLogic.h"
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+GameLogic::GameLogic(vec3 sword_box_size, vec3 enemy_box_size, double tick_rate) {
+	tick_dt = 1.0 / tick_rate;
+	accumulator = 0.0;
+	HP = HP_LIMIT;
+	score = 0;
+	start_game = false;
+	game_win = false;
+	timer_started = false;
+	elapsed = 0.0;
+	sim_time = 0.0;
+	keyframes.resize(MAX_ENEMIES);
+	path_slots.resize(MAX_ENEMIES);
+	path_distances.resize(MAX_ENEMIES);
+	path_samples.resize(MAX_ENEMIES);
+
+	for (unsigned int i = 0; i < NUM_PLAYERS; i++) {
+		sword_boxes[i] = createSwordBox(sword_box_size);
+	}
+	enemy_box = new Bound(enemy_box_size.x / 4.0f, enemy_box_size.y / 4.0f, enemy_box_size.z / 4.0f);
+
+	initialize_enemy_paths();
+
+	// Designers edit the wave file. Without one, the built-in schedule keeps the game playable
+	if (!waves.load(WAVE_FILE_PATH)) {
+		waves.parse(DEFAULT_WAVES, "built-in waves");
+	}
+}
+
+GameLogic::~GameLogic() {
+	for (unsigned int i = 0; i < NUM_PLAYERS; i++) {
+		delete sword_boxes[i];
+	}
+	delete enemy_box;
+	for (Curve * path : path_container) {
+		delete path;
+	}
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+void GameLogic::initialize_enemy_paths() {
+	// Front path
+	vec4 p0 = vec4(0, -0.2f, -10.0f, 1.0f);
+	vec4 p1 = vec4(-7.0f, 0.9f, -2.8f, 1.0f);
+	vec4 p2 = vec4(7.0f, -0.2f, -1.4f, 1.0f);
+	vec4 p3 = vec4(0, -0.2f, 1.0f, 1.0f);
+	path_container.push_back(new Curve(mat4(p0, p1, p2, p3)));
+
+	// Back path
+	p0 = vec4(0.0f, 8.0f, 10.0f, 1.0f);
+	p1 = vec4(7.0f, 0.9f, 7.0f, 1.0f);
+	p2 = vec4(-4.0f, 5.0f, 4.0f, 1.0f);
+	path_container.push_back(new Curve(mat4(p0, p1, p2, p3)));
+
+	// Left path
+	p0 = vec4(-7.0f, 1.0f, 0.0f, 1.0f);
+	p1 = vec4(-5.5f, -1.0f, 1.0f, 1.0f);
+	p2 = vec4(-2.0f, -0.2f, 1.0f, 1.0f);
+	path_container.push_back(new Curve(mat4(p0, p1, p2, p3)));
+
+	// Right path
+	p0 = vec4(9.0f, 2.0f, -3.0f, 1.0f);
+	p1 = vec4(6.4f, 0.0f, 1.0f, 1.0f);
+	p2 = vec4(4.5f, 0.0f, 1.2f, 1.0f);
+	path_container.push_back(new Curve(mat4(p0, p1, p2, p3)));
+}
+
+void GameLogic::despawnEnemy(unsigned int slot) {
+	enemies.despawn(slot);
+}
+
+Bound * GameLogic::createSwordBox(vec3 sword_box_size) {
+	Bound * box = new Bound(sword_box_size.x / 4.0f, sword_box_size.y / 4.0f, sword_box_size.z / 4.0f);
+	// Long and thin, and swung at any angle, so its AABB would be far too generous
+	box->shape = BOUND_OBB;
+	box->toWorld = glm::translate(mat4(1.0f), vec3(0.002f, 0.27f, -0.39f)) *
+					glm::rotate(mat4(1.0f), 33.0f / 180.0f * glm::pi<float>(), vec3(1.0f, 0, 0))
+					* glm::rotate(mat4(1.0f), 90.0f / 180.0f * glm::pi<float>(), vec3(0, 1.0f, 0));
+	return box;
+}
+
+vec3 GameLogic::objBoxDimensions(const char * path, float scale_size) {
+	FILE * fp = fopen(path, "r");
+	if (!fp) {
+		std::cerr << "Could not open " << path << " to size its hitbox!" << std::endl;
+		return vec3(0.0f);
+	}
+
+	vec3 min_pos(FLT_MAX);
+	vec3 max_pos(-FLT_MAX);
+	char ln[256];
+	// Only vertex positions matter for the box, so skip everything else
+	while (fgets(ln, sizeof(ln), fp)) {
+		vec3 v;
+		if (ln[0] == 'v' && ln[1] == ' ' && sscanf(ln + 2, "%f %f %f", &v.x, &v.y, &v.z) == 3) {
+			for (int i = 0; i < 3; i++) {
+				if (v[i] < min_pos[i]) min_pos[i] = v[i];
+				if (v[i] > max_pos[i]) max_pos[i] = v[i];
+			}
+		}
+	}
+	fclose(fp);
+
+	// Same normalization as Model::centerAndResize (largest side bound to 0.5)
+	vec3 dims = max_pos - min_pos;
+	float size = glm::max(dims.x, glm::max(dims.y, dims.z));
+	if (size <= 0.0f) {
+		return vec3(0.0f);
+	}
+	return dims * (0.5f / size) * scale_size;
+}
+
+/*----------------- MORE GAME-RELATED FUNCTIONS -----------------*/
+void GameLogic::startTimer() {
+	if (timer_started) {
+		return;
+	}
+	std::cout << "Please wait 5 seconds..." << std::endl;
+	timer_started = true;
+	elapsed = 0.0;
+}
+
+bool GameLogic::timerStarted() {
+	return timer_started;
+}
+
+double GameLogic::tickLength() {
+	return tick_dt;
+}
+
+unsigned int GameLogic::update(double frame_dt, const mat4 * hand_transforms) {
+	unsigned int events = 0;
+	accumulator += frame_dt;
+
+	unsigned int ticks = 0;
+	while (accumulator >= tick_dt) {
+		if (++ticks > MAX_TICKS_PER_UPDATE) {
+			// Too far behind (a hitch or a breakpoint). Drop the backlog rather than fast-forwarding through it
+			accumulator = 0.0;
+			break;
+		}
+		events |= tick(tick_dt, hand_transforms);
+		accumulator -= tick_dt;
+	}
+	return events;
+}
+
+vec3 GameLogic::enemyPosition(unsigned int slot) {
+	float alpha = (float)(accumulator / tick_dt);
+	float from = enemies.prev_distances[slot];
+	float to = enemies.distances[slot];
+	return path_container[enemies.paths[slot]]->pointAtDistance(from + (to - from) * alpha);
+}
+
+void GameLogic::fillSnapshot(WorldSnapshot & snapshot) {
+	snapshot.HP = (short)HP;
+	snapshot.score = (unsigned short)score;
+	snapshot.time = (unsigned int)(sim_time * 1000.0 + 0.5);
+
+	snapshot.entities.clear();
+	for (unsigned int slot : enemies.live) {
+		// A new id is a new spawn in the slot
+		EntityState & key = keyframes[slot];
+		if (key.id != enemies.ids[slot] || key.path != enemies.paths[slot] || key.type != enemies.types[slot]
+			|| key.speed != enemies.speeds[slot] || fabsf(key.positionAt(snapshot.time) - enemies.distances[slot]) > SNAPSHOT_ENTITY_DRIFT) {
+			key.id = enemies.ids[slot];
+			key.path = enemies.paths[slot];
+			key.type = enemies.types[slot];
+			key.speed = enemies.speeds[slot];
+			key.position = enemies.distances[slot];
+			key.time = snapshot.time;
+		}
+		snapshot.entities.push_back(key);
+	}
+	// Snapshots keep entities sorted by id
+	std::sort(snapshot.entities.begin(), snapshot.entities.end(),
+		[](const EntityState & a, const EntityState & b) { return a.id < b.id; });
+}
+
+void GameLogic::applySnapshot(const WorldSnapshot & snapshot) {
+	HP = snapshot.HP;
+	score = snapshot.score;
+
+	// Mirror the server's pool: ids carry the slot, so matching enemies keep their slot and render history
+	unsigned int previous[MAX_ENEMIES];
+	unsigned int previous_count = 0;
+	for (unsigned int slot : enemies.live) {
+		previous[previous_count++] = slot;
+	}
+	for (const EntityState & enemy : snapshot.entities) {
+		if (enemy.path >= path_container.size()) {
+			continue;
+		}
+		unsigned int slot = enemies.slotOf(enemy.id);
+		if (slot == ENEMY_NONE) {
+			// Whatever still holds the id's slot was replaced on the server, take it out as well
+			despawnEnemy(enemy.id & (MAX_ENEMIES - 1));
+			slot = enemies.spawnWithId(enemy.id, enemy.path, enemy.speed, enemy.type, enemy.positionAt(snapshot.time));
+		}
+		enemies.distances[slot] = enemy.positionAt(snapshot.time);
+		enemies.speeds[slot] = enemy.speed;
+	}
+	// Enemies the server no longer has
+	unsigned int entity = 0;
+	std::sort(previous, previous + previous_count,
+		[this](unsigned int a, unsigned int b) { return enemies.ids[a] < enemies.ids[b]; });
+	for (unsigned int i = 0; i < previous_count; i++) {
+		unsigned short id = enemies.ids[previous[i]];
+		while (entity < snapshot.entities.size() && snapshot.entities[entity].id < id) {
+			entity++;
+		}
+		if (entity == snapshot.entities.size() || snapshot.entities[entity].id != id) {
+			despawnEnemy(previous[i]);
+		}
+	}
+}
+
+unsigned int GameLogic::tick(double dt, const mat4 * hand_transforms) {
+	if (!timer_started) {
+		return 0;
+	}
+	sim_time += dt;
+	elapsed += dt;
+
+	// Do not go through main game logic until 5 seconds after start
+	if (!start_game) {
+		if (elapsed > GAME_START_DELAY) {
+			start_game = true;
+			elapsed = 0.0;
+			std::cout << "GAME START!" << std::endl;
+			return EVENT_GAME_START;
+		}
+		return 0;
+	}
+	// Check if players won
+	if (elapsed >= GAME_TIME_LIMIT) {
+		return handleGameState(true);
+	}
+	// Check if players lost
+	if (HP <= 0) {
+		return handleGameState(false);
+	}
+	// Continue main game updates
+	return handleMainGameLogic(dt, hand_transforms);
+}
+
+unsigned int GameLogic::handleMainGameLogic(double dt, const mat4 * hand_transforms) {
+	unsigned int events = 0;
+
+	// Update sword bounding boxes
+	for (unsigned int p = 0; p < NUM_PLAYERS; p++) {
+		sword_boxes[p]->update(hand_transforms[p]);
+	}
+
+	// Enemies the wave file has due by now (they start moving next tick)
+	waves.update(elapsed, enemies, (unsigned int)path_container.size());
+
+	// Group the live enemies by path (counting sort: count, turn the counts into ends, fill each path backwards)
+	unsigned int path_count = (unsigned int)path_container.size();
+	path_starts.assign(path_count + 1, 0);
+	for (unsigned int slot : enemies.live) {
+		path_starts[enemies.paths[slot]]++;
+	}
+	unsigned int total = 0;
+	for (unsigned int path = 0; path < path_count; path++) {
+		total += path_starts[path];
+		path_starts[path] = total;
+	}
+	path_starts[path_count] = total;
+	for (unsigned int i = (unsigned int)enemies.live.size(); i-- > 0;) {
+		unsigned int slot = enemies.live[i];
+		unsigned int entry = --path_starts[enemies.paths[slot]];
+		path_slots[entry] = slot;
+		path_distances[entry] = enemies.distances[slot];
+	}
+
+	// Move each enemy's hitbox, evaluating every enemy on a path in one batch
+	for (unsigned int path = 0; path < path_count; path++) {
+		unsigned int first = path_starts[path];
+		unsigned int count = path_starts[path + 1] - first;
+		if (count == 0) {
+			continue;
+		}
+		path_container[path]->evaluateBatchAtDistances(&path_distances[first], count, path_samples);
+		for (unsigned int i = 0; i < count; i++) {
+			unsigned int slot = path_slots[first + i];
+			enemies.prev_distances[slot] = enemies.distances[slot];
+			vec3 position(path_samples.x[i], path_samples.y[i], path_samples.z[i]);
+			enemy_box->update(glm::translate(mat4(1.0f), position));
+			enemies.boxes[slot] = enemy_box->box;
+			enemies.oriented_boxes[slot] = enemy_box->oriented_box;
+		}
+	}
+
+	// Only enemies near a sword's swing since the last tick go through the swept narrow phase
+	AABB swings[NUM_PLAYERS];
+	for (unsigned int p = 0; p < NUM_PLAYERS; p++) {
+		swings[p] = sword_boxes[p]->sweptBounds();
+	}
+	broad_phase.queryPairs(enemies.boxes.data(), enemies.live.data(), (unsigned int)enemies.live.size(),
+		swings, NUM_PLAYERS, candidate_pairs);
+
+	for (const BroadPhasePair & pair : candidate_pairs) {
+		unsigned int slot = pair.id;
+		if (enemies.hp[slot] > 0 && sword_boxes[pair.query]->sweptOverlap(enemies.boxes[slot], enemies.oriented_boxes[slot])) {
+			enemies.hp[slot]--;
+		}
+	}
+
+	// Backwards, so a despawn only moves an enemy that was already handled into the current position
+	for (unsigned int i = (unsigned int)enemies.live.size(); i-- > 0;) {
+		unsigned int slot = enemies.live[i];
+
+		if (enemies.hp[slot] <= 0) {
+			score++;
+			events |= EVENT_MONSTER_DEATH;
+			despawnEnemy(slot);
+			continue;
+		}
+
+		// Update monster movement
+		enemies.distances[slot] += enemies.speeds[slot] * (float)dt;
+
+		// Check if enemy has reached the cat
+		if (enemies.distances[slot] >= path_container[enemies.paths[slot]]->length()) {
+			HP--;
+			events |= EVENT_CAT_HIT;
+			despawnEnemy(slot);
+		}
+	}
+
+	// Check if low HP
+	if (HP <= LOW_HEALTH_LIMIT) {
+		events |= EVENT_CAT_LOW_HEALTH;
+	}
+
+	return events;
+}
+
+unsigned int GameLogic::handleGameState(bool wonGame) {
+	game_win = wonGame;
+	std::cout << (wonGame ? "YOU WIN!" : "YOU LOSE!") << std::endl;
+
+	// Reset states, next match starts after the countdown
+	start_game = false;
+	elapsed = 0.0;
+	HP = HP_LIMIT;
+	score = 0;
+	enemies.clear();
+	waves.reset();
+
+	return wonGame ? EVENT_GAME_WIN : EVENT_GAME_OVER;
+}
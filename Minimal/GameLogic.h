@@ -0,0 +1,145 @@
+/* Authoritative game simulation (enemy paths, sword hit detection, cat HP and match timer)
+ * Has no GL/OVR/AL dependency so it can run inside the Rift app or the headless dedicated server
+ */
+#pragma once
+#ifndef _GAME_LOGIC_H_
+#define _GAME_LOGIC_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+#include "Curve.h"
+#include "Bound.h"
+#include "BroadPhase.h"
+#include "EnemyPool.h"
+#include "WaveScheduler.h"
+#include "Snapshot.h"
+
+// Limits
+#define GAME_TIME_LIMIT 60.0
+#define GAME_START_DELAY 5.0
+#define HP_LIMIT 10
+#define LOW_HEALTH_LIMIT 4
+
+#define NUM_PLAYERS 2
+#define NUM_ENEMY_PATHS 4
+
+// Default rate of the fixed simulation tick, independent of the display rate
+#define SIM_TICK_RATE 60
+#define SIM_TICK_DT (1.0 / SIM_TICK_RATE)
+// Ticks run per update before the accumulator is dropped (stops a slow frame from snowballing)
+#define MAX_TICKS_PER_UPDATE 8
+
+// Used when there is no wave file: a steady stream down each path at 1.2 units per second (about the old speed)
+// Columns: time path type count interval speed
+#define DEFAULT_WAVES \
+	"0 0 0 6 10 1.2\n" \
+	"0 1 0 6 10 1.2\n" \
+	"0 2 0 6 10 1.2\n" \
+	"0 3 0 6 10 1.2\n"
+
+// Models the hitboxes are sized from and the scale they are drawn at
+#define SWORD_MODEL_PATH "assets/models/obj/sword_obj.obj"
+#define ENEMY_MODEL_PATH "assets/models/obj/cacodemon.obj"
+#define SWORD_SCALE 1.4f
+#define ENEMY_SCALE 1.5f
+
+// Events raised by a tick (bit flags). The Rift app maps these to sounds
+#define EVENT_MONSTER_DEATH		(1 << 0)
+#define EVENT_CAT_HIT			(1 << 1)
+#define EVENT_CAT_LOW_HEALTH	(1 << 2)
+#define EVENT_GAME_START		(1 << 3)
+#define EVENT_GAME_WIN			(1 << 4)
+#define EVENT_GAME_OVER			(1 << 5)
+
+class GameLogic {
+public:
+	/* State */
+	int HP;											// HP of the cat
+	unsigned int score;								// Enemies killed this match
+	bool start_game;								// Enemies are moving
+	bool game_win;									// Result of the last match
+	EnemyPool enemies;								// Live enemies and their positions along the paths
+	std::vector<Curve *> path_container;			// Enemy paths
+
+	/* GameLogic constructor
+	 * sword_box_size - dimensions of the (scaled) sword model
+	 * enemy_box_size - dimensions of the (scaled) enemy model
+	 * tick_rate - fixed simulation ticks per second
+	 */
+	GameLogic(glm::vec3 sword_box_size, glm::vec3 enemy_box_size, double tick_rate = SIM_TICK_RATE);
+	~GameLogic();
+
+	// Start the countdown to the first match (once every player has connected)
+	void startTimer();
+	bool timerStarted();
+
+	/* Advance the simulation by one tick
+	 * dt - length of the tick in seconds
+	 * hand_transforms - right hand transformation of each player
+	 * returns the EVENT_* flags raised during the tick
+	 */
+	unsigned int tick(double dt, const glm::mat4 * hand_transforms);
+
+	/* Run as many fixed ticks as fit in the time since the last update (the rest carries over)
+	 * frame_dt - seconds since the last update
+	 * hand_transforms - right hand transformation of each player
+	 * returns the EVENT_* flags raised by every tick run
+	 */
+	unsigned int update(double frame_dt, const glm::mat4 * hand_transforms);
+
+	// Length of a fixed tick in seconds
+	double tickLength();
+
+	// Where to draw an enemy (by pool slot): blended between the last two ticks by the time left in the accumulator
+	glm::vec3 enemyPosition(unsigned int slot);
+
+	/* Write HP, score and the enemies into a snapshot (players are filled by the caller)
+	 * Enemies go in as keyframes, re-keyed only when clients would extrapolate them too far off (see Snapshot.h)
+	 */
+	void fillSnapshot(WorldSnapshot & snapshot);
+	// Overwrite HP, score and the enemies with the server's snapshot
+	void applySnapshot(const WorldSnapshot & snapshot);
+
+	// Sword hitbox in the hand's coordinate system. Shared with Player so the debug box matches
+	static Bound * createSwordBox(glm::vec3 sword_box_size);
+
+	/* Dimensions of an obj model after Model::centerAndResize and the given scale, without loading it on the GPU
+	 * path - path to the obj file
+	 * scale_size - scale applied to the model once it is loaded
+	 */
+	static glm::vec3 objBoxDimensions(const char * path, float scale_size);
+
+private:
+	/* Private Data */
+	bool timer_started;
+	double elapsed;						// Seconds since the countdown or the match started
+	double sim_time;					// Seconds simulated since construction (the snapshot clock)
+	double tick_dt;
+	double accumulator;					// Time not yet simulated, less than one tick
+	Bound * sword_boxes[NUM_PLAYERS];	// Sword hitbox of each player
+	Bound * enemy_box;					// Hitbox moved to each enemy in turn (they keep its boxes in the pool)
+	BroadPhase broad_phase;				// Sword/enemy candidate search
+	WaveScheduler waves;				// When and where enemies spawn
+	std::vector<BroadPhasePair> candidate_pairs;	// Sword/enemy pairs from the broad phase, reused every tick
+	std::vector<EntityState> keyframes;	// Per pool slot: the state last put in a snapshot, clients extrapolate from it
+	// Live enemies grouped by path each tick, so every path's hitboxes come from one batch evaluation
+	std::vector<unsigned int> path_starts;		// First entry of each path in path_slots, plus the end
+	std::vector<unsigned int> path_slots;		// Pool slots, grouped by path
+	std::vector<float> path_distances;			// Distance of each entry in path_slots
+	CurveSamples path_samples;					// Positions of one path's enemies
+
+	/* Private Functions */
+	void initialize_enemy_paths();
+	// Take an enemy out of the pool
+	void despawnEnemy(unsigned int slot);
+	unsigned int handleMainGameLogic(double dt, const glm::mat4 * hand_transforms);
+	unsigned int handleGameState(bool wonGame);
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "GeometryArena.h"
+#include <stdio.h>
+#include <stddef.h>
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+GeometryArena::GeometryArena() {
+	multi_draw_indirect = GLEW_ARB_multi_draw_indirect != 0;
+	base_instance = GLEW_ARB_base_instance != 0;
+	printf("Geometry arena: %s\n", multi_draw_indirect ? "multi draw indirect" :
+		base_instance ? "base vertex/base instance draws" : "base vertex draws");
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &command_buffer);
+	vertex_capacity = ARENA_VERTEX_CAPACITY;
+	index_capacity = ARENA_INDEX_CAPACITY;
+	grow(VBO, 0, vertex_capacity * sizeof(Vertex), GL_STATIC_DRAW);
+	grow(EBO, 0, index_capacity * sizeof(unsigned int), GL_STATIC_DRAW);
+	matrix_capacity = ARENA_MATRIX_CAPACITY;
+	// Rewritten every frame
+	grow(matrix_buffer, 0, matrix_capacity * sizeof(glm::mat4), GL_STREAM_DRAW);
+	setupAttributes();
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+void GeometryArena::grow(GLuint & buffer, size_t used, size_t capacity, GLenum usage) {
+	GLuint bigger;
+	glGenBuffers(1, &bigger);
+	glState().bindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, usage);
+	if (buffer != 0) {
+		if (used > 0) {
+			glState().bindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+		}
+		glDeleteBuffers(1, &buffer);
+		glState().deletedBuffer(buffer);
+	}
+	buffer = bigger;
+}
+
+void GeometryArena::setupAttributes() {
+	glState().bindVertexArray(VAO);
+	glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+	// vertex Positions
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	// vertex normals
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	// vertex texture coords
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+	// Model matrix of each draw, advancing once per instance (per pair of eye instances with single-pass stereo)
+	for (unsigned int column = 0; column < 4; column++) {
+		glEnableVertexAttribArray(INSTANCE_MATRIX_ATTRIB + column);
+		glVertexAttribDivisor(INSTANCE_MATRIX_ATTRIB + column, divisor);
+	}
+	pointMatrices(0);
+}
+
+void GeometryArena::pointMatrices(GLuint first_matrix) {
+	glState().bindBuffer(GL_ARRAY_BUFFER, matrix_buffer);
+	for (unsigned int column = 0; column < 4; column++) {
+		glVertexAttribPointer(INSTANCE_MATRIX_ATTRIB + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+			(void*)(first_matrix * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+	}
+}
+
+/*------------------------ ARENA FUNCTIONS ---------------------------*/
+ArenaRange GeometryArena::allocate(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices) {
+	// Models are loaded up front, so growing (a copy on the GPU) only happens while loading
+	bool grew = false;
+	if (vertex_count + vertices.size() > vertex_capacity) {
+		while (vertex_count + vertices.size() > vertex_capacity) {
+			vertex_capacity *= 2;
+		}
+		grow(VBO, vertex_count * sizeof(Vertex), vertex_capacity * sizeof(Vertex), GL_STATIC_DRAW);
+		grew = true;
+	}
+	if (index_count + indices.size() > index_capacity) {
+		while (index_count + indices.size() > index_capacity) {
+			index_capacity *= 2;
+		}
+		grow(EBO, index_count * sizeof(unsigned int), index_capacity * sizeof(unsigned int), GL_STATIC_DRAW);
+		grew = true;
+	}
+	if (grew) {
+		setupAttributes();
+	}
+
+	ArenaRange range;
+	range.first_index = index_count;
+	range.index_count = (GLuint)indices.size();
+	range.base_vertex = (GLint)vertex_count;
+
+	// Both go through the array buffer binding, so the vertex array's element buffer is left alone
+	if (!vertices.empty()) {
+		glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, vertex_count * sizeof(Vertex), vertices.size() * sizeof(Vertex), vertices.data());
+	}
+	if (!indices.empty()) {
+		glState().bindBuffer(GL_ARRAY_BUFFER, EBO);
+		glBufferSubData(GL_ARRAY_BUFFER, index_count * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indices.data());
+	}
+	vertex_count += (unsigned int)vertices.size();
+	index_count += (unsigned int)indices.size();
+	return range;
+}
+
+void GeometryArena::upload(const std::vector<glm::mat4> & matrices, const std::vector<DrawCommand> & commands) {
+	if (!matrices.empty()) {
+		glState().bindBuffer(GL_ARRAY_BUFFER, matrix_buffer);
+		if (matrices.size() > matrix_capacity) {
+			// Grow to the next power of two so a growing wave doesn't reallocate every frame
+			while (matrix_capacity < matrices.size()) {
+				matrix_capacity *= 2;
+			}
+			glBufferData(GL_ARRAY_BUFFER, matrix_capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+	}
+
+	if (multi_draw_indirect && !commands.empty()) {
+		glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+		if (commands.size() > command_capacity) {
+			command_capacity = command_capacity ? command_capacity : 64;
+			while (command_capacity < commands.size()) {
+				command_capacity *= 2;
+			}
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, command_capacity * sizeof(DrawCommand), NULL, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawCommand), commands.data());
+	}
+}
+
+void GeometryArena::draw(const std::vector<DrawCommand> & commands, unsigned int first, unsigned int count) {
+	glState().bindVertexArray(VAO);
+	// With single-pass stereo each matrix is shared by the two eye instances drawn after one another
+	unsigned int wanted = stereoInstances(1);
+	if (wanted != divisor) {
+		for (unsigned int column = 0; column < 4; column++) {
+			glVertexAttribDivisor(INSTANCE_MATRIX_ATTRIB + column, wanted);
+		}
+		divisor = wanted;
+	}
+
+	if (multi_draw_indirect) {
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(first * sizeof(DrawCommand)), count, sizeof(DrawCommand));
+		meshDrawCalls()++;
+		return;
+	}
+
+	for (unsigned int i = first; i < first + count; i++) {
+		const DrawCommand & command = commands[i];
+		void * offset = (void*)(command.first_index * sizeof(unsigned int));
+		if (base_instance) {
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.index_count, GL_UNSIGNED_INT, offset,
+				command.instance_count, command.base_vertex, command.base_instance);
+		}
+		else {
+			pointMatrices(command.base_instance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.index_count, GL_UNSIGNED_INT, offset,
+				command.instance_count, command.base_vertex);
+		}
+		meshDrawCalls()++;
+	}
+}
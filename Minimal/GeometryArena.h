@@ -0,0 +1,124 @@
+/* Geometry arena: one vertex buffer and one index buffer that every Mesh suballocates from
+ * All meshes share a single vertex array, so the render queue can draw a whole run of meshes (same
+ * shader and textures) with one glMultiDrawElementsIndirect. Each draw finds its model matrix in the
+ * draw matrix buffer through its base instance (per-instance attribute at INSTANCE_MATRIX_ATTRIB).
+ * Without multi draw indirect the commands are issued one by one with base-vertex draws.
+ */
+#pragma once
+#ifndef _GEOMETRY_ARENA_H_
+#define _GEOMETRY_ARENA_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+#include "Stereo.h"
+#include "GLState.h"
+
+// First vertex attribute of the per-draw model matrix (a mat4 takes four locations)
+#define INSTANCE_MATRIX_ATTRIB 3
+// Room the shared buffers start with (they double when a model doesn't fit)
+#define ARENA_VERTEX_CAPACITY 65536
+#define ARENA_INDEX_CAPACITY 196608
+#define ARENA_MATRIX_CAPACITY 64
+
+// Draw calls issued for meshes since it was last reset (to check how the count scales with the scene)
+inline unsigned int & meshDrawCalls() {
+	static unsigned int count = 0;
+	return count;
+}
+
+struct Vertex {
+	// position
+	glm::vec3 Position;
+	// normal
+	glm::vec3 Normal;
+	// texCoords
+	glm::vec2 TexCoords;
+	/*
+	// tangent
+	glm::vec3 Tangent;
+	// bitangent
+	glm::vec3 Bitangent;
+	*/
+};
+
+// Where a mesh lives in the arena
+struct ArenaRange {
+	GLuint first_index;		// First of its indices in the index buffer
+	GLuint index_count;
+	GLint base_vertex;		// Added to its indices (they stay local to the mesh)
+};
+
+// One draw, laid out the way glMultiDrawElementsIndirect reads it
+struct DrawCommand {
+	GLuint index_count;
+	GLuint instance_count;	// Per eye copies times the eyes drawn
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;	// First model matrix of the draw in the draw matrix buffer
+};
+
+class GeometryArena {
+public:
+	GLuint VAO = 0;		// Reads every mesh's vertices, and the draw matrices
+
+	GeometryArena();
+
+	/* Copy a mesh into the shared buffers
+	 * vertices - the mesh's vertices
+	 * indices - its indices (relative to its first vertex)
+	 */
+	ArenaRange allocate(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices);
+	/* Upload the model matrices and commands of everything drawn this pass
+	 * matrices - model matrices, addressed by the commands' base instance
+	 * commands - the draws
+	 */
+	void upload(const std::vector<glm::mat4> & matrices, const std::vector<DrawCommand> & commands);
+	/* Draw a run of the uploaded commands (the shader and textures they share must be bound)
+	 * commands - the commands given to upload
+	 * first - first command of the run
+	 * count - commands in the run
+	 */
+	void draw(const std::vector<DrawCommand> & commands, unsigned int first, unsigned int count);
+
+private:
+	GLuint VBO = 0, EBO = 0;
+	GLuint matrix_buffer = 0;			// Per-draw model matrices
+	GLuint command_buffer = 0;			// GL_DRAW_INDIRECT_BUFFER with the pass's commands
+	unsigned int vertex_count = 0, vertex_capacity = 0;
+	unsigned int index_count = 0, index_capacity = 0;
+	unsigned int matrix_capacity = 0, command_capacity = 0;
+	unsigned int divisor = 1;			// Instances per model matrix (2 with single-pass stereo)
+	bool multi_draw_indirect;			// glMultiDrawElementsIndirect available
+	bool base_instance;					// Per-draw base instance available (else the matrix attribute is moved per draw)
+
+	// Point the vertex array at the shared buffers (again after they grew)
+	void setupAttributes();
+	// Point the matrix attribute at a model matrix in the draw matrix buffer
+	void pointMatrices(GLuint first_matrix);
+	/* Replace a buffer with a bigger one, keeping its first used bytes
+	 * usage - GL_STATIC_DRAW for geometry loaded once, GL_STREAM_DRAW for data rewritten every frame
+	 */
+	static void grow(GLuint & buffer, size_t used, size_t capacity, GLenum usage);
+};
+
+// The arena all meshes are loaded into (created with the first mesh)
+inline GeometryArena & geometryArena() {
+	static GeometryArena arena;
+	return arena;
+}
+
+#endif
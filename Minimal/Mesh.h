@@ -14,31 +14,30 @@
 #include <GLFW/glfw3.h>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/glm.hpp>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <map>
+#include <algorithm>
+#include <float.h>
 
 #include "Shader.h"
+#include "Stereo.h"
+#include "FrameUniforms.h"
+#include "Frustum.h"
+#include "GeometryArena.h"
 
 using namespace std;
 
-struct Vertex {
-	// position
-	glm::vec3 Position;
-	// normal
-	glm::vec3 Normal;
-	// texCoords
-	glm::vec2 TexCoords;
-	/*
-	// tangent
-	glm::vec3 Tangent;
-	// bitangent
-	glm::vec3 Bitangent;
-	*/
-};
+// Meshes skipped by frustum culling since it was last reset
+inline unsigned int & meshesCulled() {
+	static unsigned int count = 0;
+	return count;
+}
 
 struct Texture {
 	unsigned int id;
@@ -46,13 +45,32 @@ struct Texture {
 	string path;
 };
 
+/* Small id for a set of textures bound to a set of samplers, so meshes sharing a material sort together
+ * samplers - sampler uniform and texture bound to it, in texture unit order
+ */
+inline unsigned int materialId(const vector<pair<string, unsigned int>> & samplers) {
+	static map<vector<pair<string, unsigned int>>, unsigned int> ids;
+	map<vector<pair<string, unsigned int>>, unsigned int>::iterator found = ids.find(samplers);
+	if (found != ids.end())
+		return found->second;
+	unsigned int id = (unsigned int)ids.size();
+	ids[samplers] = id;
+	return id;
+}
+
 class Mesh {
 public:
 	/*  Mesh Data  */
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
 	vector<Texture> textures;
-	unsigned int VAO;
+	ArenaRange range;			// Where the vertices and indices are in the arena
+	unsigned int material;		// Shared by meshes binding the same textures to the same samplers (see materialId)
+	/*  Bounds (local space, computed at load)  */
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+	glm::vec3 sphere_center;
+	float sphere_radius;
 
 	/*  Functions  */
 	// constructor
@@ -62,22 +80,55 @@ public:
 		this->indices = indices;
 		this->textures = textures;
 
-		// now that we have all the required data, set the vertex buffers and its attribute pointers.
+		// now that we have all the required data, copy it into the shared vertex and index buffers.
 		setupMesh();
+		setupSamplerNames();
+		setupBounds();
+	}
+
+	/* True unless the mesh is entirely outside the frustum (counts it in meshesCulled() when it is)
+	 * frustum - frustum of the pass
+	 * M - model matrix the mesh would be drawn with
+	 */
+	bool visibleIn(const Frustum & frustum, const glm::mat4 & M) const
+	{
+		if (frustum.containsBounds(M, bounds_min, bounds_max, sphere_center, sphere_radius))
+			return true;
+		meshesCulled()++;
+		return false;
+	}
+
+	/* Bind the mesh's textures to units 0..n and point the shader's samplers at them
+	 * shader - glsl shader in use
+	 */
+	void bindTextures(const Shader & shader)
+	{
+		updateSamplers(shader);
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			// set the sampler to the correct texture unit
+			glUniform1i(sampler_locations[i], i);
+			// and bind the texture there (the unit is only made active if its texture changes)
+			glState().bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+		}
 	}
 
-	// render the mesh
-	void Draw(Shader shader, glm::mat4 M, glm::mat4 V, glm::mat4 P)
+private:
+	/*  Render data  */
+	vector<string> sampler_names;		// Sampler uniform of each texture (texture_diffuseN, texture_specularN, ...)
+	vector<GLint> sampler_locations;	// Their locations in sampler_program
+	unsigned int sampler_program = 0;	// Shader the locations were looked up in
+
+	/*  Functions    */
+	// names the sampler each texture binds to: the N in diffuse_textureN counts up per texture type, and finds the material id
+	void setupSamplerNames()
 	{
-		// bind appropriate textures
 		unsigned int diffuseNr = 1;
 		unsigned int specularNr = 1;
 		unsigned int normalNr = 1;
 		unsigned int heightNr = 1;
 		for (unsigned int i = 0; i < textures.size(); i++)
 		{
-			glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-											  // retrieve texture number (the N in diffuse_textureN)
 			string number;
 			string name = textures[i].type;
 			if (name == "texture_diffuse")
@@ -88,72 +139,50 @@ public:
 				number = std::to_string(normalNr++); // transfer unsigned int to stream
 			else if (name == "texture_height")
 				number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-			// and finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			sampler_names.push_back(name + number);
 		}
 
-		// Set MVP matrices in shader
-		shader.setMat4("model", M);
-		shader.setMat4("view", V);
-		shader.setMat4("projection", P);
+		vector<pair<string, unsigned int>> samplers;
+		for (unsigned int i = 0; i < textures.size(); i++)
+			samplers.push_back(make_pair(sampler_names[i], textures[i].id));
+		material = materialId(samplers);
+	}
+
+	// box around the vertex positions, and a sphere around the box's center
+	void setupBounds()
+	{
+		bounds_min = glm::vec3(FLT_MAX);
+		bounds_max = glm::vec3(-FLT_MAX);
+		for (unsigned int i = 0; i < vertices.size(); i++)
+		{
+			bounds_min = glm::min(bounds_min, vertices[i].Position);
+			bounds_max = glm::max(bounds_max, vertices[i].Position);
+		}
+		if (vertices.empty())
+			bounds_min = bounds_max = glm::vec3(0.0f);
 
-		// draw mesh
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+		sphere_center = (bounds_min + bounds_max) * 0.5f;
+		sphere_radius = 0.0f;
+		for (unsigned int i = 0; i < vertices.size(); i++)
+			sphere_radius = std::max(sphere_radius, glm::length(vertices[i].Position - sphere_center));
+	}
 
-		// always good practice to set everything back to defaults once configured.
-		//glActiveTexture(GL_TEXTURE0);
-		glActiveTexture(0);
+	// looks the sampler locations up again only when drawn with a different shader than last time
+	void updateSamplers(const Shader & shader)
+	{
+		if (shader.ID == sampler_program)
+			return;
+		sampler_locations.resize(sampler_names.size());
+		for (unsigned int i = 0; i < sampler_names.size(); i++)
+			sampler_locations[i] = shader.location(sampler_names[i]);
+		sampler_program = shader.ID;
 	}
 
-private:
-	/*  Render data  */
-	unsigned int VBO, EBO;
 
-	/*  Functions    */
-	// initializes all the buffer objects/arrays
+	// copies the vertices and indices into the geometry arena (the queue draws them from there)
 	void setupMesh()
 	{
-		// create buffers/arrays
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-
-		glBindVertexArray(VAO);
-		// load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		// A great thing about structs is that their memory layout is sequential for all its items.
-		// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-		// again translates to 3/2 floats which translates to a byte array.
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-		// set the vertex attribute pointers
-		// vertex Positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		// vertex normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-		// vertex texture coords
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-		/*
-		// vertex tangent
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-		// vertex bitangent
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		*/
-
-		glBindVertexArray(0);
+		range = geometryArena().allocate(vertices, indices);
 	}
 };
 #endif
\ No newline at end of file
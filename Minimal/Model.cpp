@@ -6,17 +6,56 @@
 Model::Model(string const &path, bool gamma = false) : gammaCorrection(gamma) {
 	toWorld = glm::mat4(1.0f);
 	loadModel(path);
+	computeBounds();
 	centerAndResize();
 }
 
-void Model::draw(Shader shader, glm::mat4 P, glm::mat4 V) {
-	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Draw(shader, toWorld, V, P);
+Model::Model(const vector<Mesh> & meshes) : meshes(meshes), gammaCorrection(false) {
+	toWorld = glm::mat4(1.0f);
+	computeBounds();
+	centerAndResize();
 }
 
-void Model::draw(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C) {
-	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Draw(shader, C * toWorld, V, P);
+void Model::draw(RenderContext & context) {
+	drawAt(context, context.transforms.top() * toWorld);
+}
+
+void Model::drawAt(const RenderContext & context, const glm::mat4 & world, GLint which_player) {
+	// Sort key depth: distance from the eye to the model's origin
+	float distance = glm::length(glm::vec3(context.view * world[3]));
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		if (!meshes[i].visibleIn(context.frustum, world)) {
+			continue;
+		}
+		context.queue->add(*context.shader, meshes[i], world, distance, which_player);
+	}
+}
+
+void Model::drawInstanced(const RenderContext & context, const vector<glm::mat4> & transforms) {
+	if (transforms.empty()) {
+		return;
+	}
+
+	// Cull whole copies against the model's bounds, only the visible ones are queued
+	instance_matrices.clear();
+	for (unsigned int i = 0; i < transforms.size(); i++) {
+		glm::mat4 world = transforms[i] * toWorld;
+		if (context.frustum.containsBounds(world, bounds_min, bounds_max, sphere_center, sphere_radius)) {
+			instance_matrices.push_back(world);
+		}
+		else {
+			meshesCulled() += (unsigned int)meshes.size();
+		}
+	}
+	if (instance_matrices.empty()) {
+		return;
+	}
+
+	// Every mesh of the model reads the same matrices
+	GLuint first_matrix = context.queue->addMatrices(instance_matrices);
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		context.queue->addInstanced(*context.shader, meshes[i], first_matrix, (unsigned int)instance_matrices.size());
+	}
 }
 
 /** Helper Functions **/
@@ -40,7 +79,7 @@ unsigned int TextureFromFile(const char *path, const string &directory)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		glState().bindTexture(0, GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -181,45 +220,33 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
 	return Mesh(vertices, indices, textures);
 }
 
-void Model::centerAndResize() {
-	// Used for centering the mesh 
-	GLfloat min_x = FLT_MAX;
-	GLfloat max_x = FLT_MIN;
-	GLfloat min_y = FLT_MAX;
-	GLfloat max_y = FLT_MIN;
-	GLfloat min_z = FLT_MAX;
-	GLfloat max_z = FLT_MIN;
-	GLfloat x, y, z;
-
-	// Find max/min of each coordinate system
-	for (Mesh mesh : meshes) {
-		for (Vertex vert : mesh.vertices) {
-			x = vert.Position.x;
-			y = vert.Position.y;
-			z = vert.Position.z;
-			// Check for min/max bounds for mesh
-			if (x > max_x) {
-				max_x = x;
-			}
-			else if (x < min_x) {
-				min_x = x;
-			}
-
-			if (y > max_y) {
-				max_y = y;
-			}
-			else if (y < min_y) {
-				min_y = y;
-			}
+void Model::computeBounds() {
+	bounds_min = glm::vec3(FLT_MAX);
+	bounds_max = glm::vec3(-FLT_MAX);
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		bounds_min = glm::min(bounds_min, meshes[i].bounds_min);
+		bounds_max = glm::max(bounds_max, meshes[i].bounds_max);
+	}
+	if (meshes.empty()) {
+		bounds_min = bounds_max = glm::vec3(0.0f);
+	}
 
-			if (z > max_z) {
-				max_z = z;
-			}
-			else if (z < min_z) {
-				min_z = z;
-			}
-		}
+	// Sphere around the box's center that holds every mesh's sphere
+	sphere_center = (bounds_min + bounds_max) * 0.5f;
+	sphere_radius = 0.0f;
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		sphere_radius = std::max(sphere_radius, glm::length(meshes[i].sphere_center - sphere_center) + meshes[i].sphere_radius);
 	}
+}
+
+void Model::centerAndResize() {
+	// Used for centering the mesh (the box computeBounds found around every vertex)
+	GLfloat min_x = bounds_min.x;
+	GLfloat max_x = bounds_max.x;
+	GLfloat min_y = bounds_min.y;
+	GLfloat max_y = bounds_max.y;
+	GLfloat min_z = bounds_min.z;
+	GLfloat max_z = bounds_max.z;
 
 	// Recenter/rescale
 	GLfloat avg_x = (max_x + min_x) / 2;
@@ -39,6 +39,10 @@ public:
 	float scale_factor;
 	glm::vec3 avg_pos;
 	glm::vec3 xyz_dimensions;	// Contains the max rectangular box dimensions of the model (taking in only the vertex data)
+	glm::vec3 bounds_min;		// Box around all meshes, before toWorld
+	glm::vec3 bounds_max;
+	glm::vec3 sphere_center;	// Sphere around all meshes, before toWorld
+	float sphere_radius;
 
 	vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
 	vector<Mesh> meshes;
@@ -48,20 +52,26 @@ public:
 	/*  Functions   */
 	// constructor, expects a filepath to a 3D model.
 	Model(string const &path, bool gamma);
+	/* Model made of meshes built in code (centered and resized like a loaded one)
+	 * meshes - the model's meshes, already in the geometry arena
+	 */
+	Model(const vector<Mesh> & meshes);
 
-	/* Draws all the model 's mesh objects 
-	 * shader - glsl shader
-	 * P - projection matrix
-	 * V - view matrix
+	/* Draws all the model 's mesh objects (queued in the context's render queue, like all model draws)
+	 * context - render state of the pass (shader, and the transform stack's top is added to the model matrix: top * toWorld)
+	 */
+	void draw(RenderContext & context);
+	/* Draws all the model 's mesh objects at a world matrix computed elsewhere (such as a SceneGraph node)
+	 * context - render state of the pass (meshes outside its frustum are skipped)
+	 * world - the full model matrix, toWorld already included
+	 * which_player - which_player uniform for player.frag, -1 for other shaders
 	 */
-	void draw(Shader shader, glm::mat4 P, glm::mat4 V);	
-	/* Draws all the model 's mesh objects
-	 * shader - glsl shader
-	 * P - projection matrix
-	 * V - view matrix
-	 * C - some transformation matrix to add to the model matrix (C * toWorld)
+	void drawAt(const RenderContext & context, const glm::mat4 & world, GLint which_player = -1);
+	/* Draws many copies of the model with one instanced draw per mesh
+	 * context - render state of the pass (copies outside its frustum are left out)
+	 * transforms - transformation matrix of each copy (C * toWorld for each C)
 	 */
-	void draw(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C);
+	void drawInstanced(const RenderContext & context, const vector<glm::mat4> & transforms);
 
 	// Transformation functions
 	void translate(float x, float y, float z);
@@ -78,6 +88,9 @@ public:
 	glm::vec3 getBoxDimensions();
 
 private:
+	/* Instancing data */
+	vector<glm::mat4> instance_matrices;	// Scratch for the matrices of the visible copies
+
 	/*  Functions   */
 	// loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
 	void loadModel(string const &path);
@@ -91,6 +104,8 @@ private:
 	// the required info is returned as a Texture struct.
 	vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName);
 
+	// Union of the meshes' bounds
+	void computeBounds();
 	// Center and resize object
 	void centerAndResize();
 };
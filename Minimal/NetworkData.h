@@ -1,6 +1,7 @@
 #pragma once
 #include <string.h>
 
+#ifndef DEDICATED_SERVER
 #define GLFW_INCLUDE_GLEXT
 #ifdef __APPLE__
 #define GLFW_INCLUDE_GLCOREARB
@@ -8,6 +9,7 @@
 #include <GL/glew.h>
 #endif
 #include <GLFW/glfw3.h>
+#endif
 // Use of degrees is deprecated. Use radians instead.
 #ifndef GLM_FORCE_RADIANS
 #define GLM_FORCE_RADIANS
@@ -17,8 +19,55 @@
 
 #include <vector>
 
+#include "PoseCodec.h"
+
 #define MAX_PACKET_SIZE 1000000
 
+// UDP datagrams carry one frame payload behind a small header: the session token (client to server only)
+// and a sequence number. Anything larger than UDP_MAX_PAYLOAD goes over TCP instead
+#define UDP_TOKEN_SIZE 4
+#define UDP_SEQUENCE_SIZE 2
+#define UDP_MAX_PAYLOAD 1200
+#define UDP_MAX_DATAGRAM (UDP_TOKEN_SIZE + UDP_SEQUENCE_SIZE + UDP_MAX_PAYLOAD)
+
+// Unreliable sequenced channel: every datagram is numbered and anything not newer than the last one received is dropped
+struct SequencedChannel {
+	unsigned short send_sequence;
+	unsigned short recv_sequence;
+	bool received_any;
+	unsigned int dropped;			// Late or duplicate datagrams thrown away
+
+	SequencedChannel() : send_sequence(0), recv_sequence(0), received_any(false), dropped(0) {}
+
+	unsigned short nextSequence() {
+		return ++send_sequence;
+	}
+
+	// True if the datagram is newer than every one accepted so far (wraps around)
+	bool accept(unsigned short sequence) {
+		if (received_any && (short)(sequence - recv_sequence) <= 0) {
+			dropped++;
+			return false;
+		}
+		received_any = true;
+		recv_sequence = sequence;
+		return true;
+	}
+};
+
+// Wire format: each packet is sent as a frame, a 2 byte little-endian payload length followed by the payload
+#define FRAME_HEADER_SIZE 2
+#define MAX_FRAME_PAYLOAD 0xFFFF
+
+inline void writeFrameHeader(char * data, unsigned int length) {
+	data[0] = (char)(length & 0xFF);
+	data[1] = (char)((length >> 8) & 0xFF);
+}
+
+inline unsigned int readFrameHeader(const char * data) {
+	return (unsigned int)(unsigned char)data[0] | ((unsigned int)(unsigned char)data[1] << 8);
+}
+
 enum PacketTypes {
 	// Send/Receive packets to indicate connection
 	INIT_CONNECTION = 0,
@@ -26,22 +75,147 @@ enum PacketTypes {
 	ACTION_EVENT = 1,
 	// Contains two mat4 data
 	HEAD_HAND_TRANSFORMS = 2,
-	// Contains path indices as well as two mat4 data
+	// Contains enemy path positions as well as two mat4 data
 	TRANSFORMS_AND_INDICES = 3,
+	// Server world state, delta-compressed against the client's last ack (see Snapshot.h)
+	WORLD_SNAPSHOT = 4,
+	// Token the client puts on its UDP datagrams so the server can match them to its session
+	UDP_CONNECT = 5,
 
 };
 
+// Enemy path positions are sent as floats (distance along the path)
+#define PATH_POSITION_WIRE_SIZE 4
+// Snapshot acks are sent as unsigned shorts
+#define ACK_WIRE_SIZE 2
+// Pose timestamps are sent as unsigned ints
+#define TIME_WIRE_SIZE 4
+// Largest serialized Packet (type byte, two poses, four path positions)
+#define MAX_PACKET_WIRE_SIZE (1 + 2 * POSE_MAX_ENCODED_SIZE + 4 * PATH_POSITION_WIRE_SIZE)
+
 struct Packet {
     unsigned int packet_type;
 	glm::mat4 hand_transform;
 	glm::mat4 head_transform;
-	unsigned int indices[4];
+	float positions[4];				// Enemy distance along each path (TRANSFORMS_AND_INDICES)
+	unsigned int ack;				// Last snapshot the client received (HEAD_HAND_TRANSFORMS)
+	unsigned int token;				// Session token for UDP datagrams (UDP_CONNECT)
+	unsigned int time;				// Sender's clock when the pose was taken, ms (HEAD_HAND_TRANSFORMS)
+
+	// Codec for the poses on the wire
+	static const PoseCodec & poseCodec() {
+		static PoseCodec codec;
+		return codec;
+	}
+
+	// Serialized size of a packet of the given type
+	static unsigned int wireSize(unsigned int type) {
+		unsigned int size = 1;
+		if (type == HEAD_HAND_TRANSFORMS || type == TRANSFORMS_AND_INDICES) {
+			size += 2 * poseCodec().encodedSize();
+		}
+		if (type == HEAD_HAND_TRANSFORMS) {
+			size += ACK_WIRE_SIZE + TIME_WIRE_SIZE;
+		}
+		if (type == TRANSFORMS_AND_INDICES) {
+			size += 4 * PATH_POSITION_WIRE_SIZE;
+		}
+		if (type == UDP_CONNECT) {
+			size += UDP_TOKEN_SIZE;
+		}
+		return size;
+	}
+
+	/* Write the compact wire form: the type byte, then only the quantized poses and positions the type carries
+	 * data - receives at most MAX_PACKET_WIRE_SIZE bytes
+	 * returns the number of bytes written
+	 */
+    unsigned int serialize(char * data) {
+		unsigned int size = 0;
+		data[size++] = (char)packet_type;
 
-    void serialize(char * data) {
-        memcpy(data, this, sizeof(Packet));
+		if (packet_type == HEAD_HAND_TRANSFORMS || packet_type == TRANSFORMS_AND_INDICES) {
+			size += poseCodec().encode(hand_transform, data + size);
+			size += poseCodec().encode(head_transform, data + size);
+		}
+		if (packet_type == HEAD_HAND_TRANSFORMS) {
+			data[size++] = (char)(ack & 0xFF);
+			data[size++] = (char)((ack >> 8) & 0xFF);
+			for (unsigned int i = 0; i < TIME_WIRE_SIZE; i++) {
+				data[size++] = (char)((time >> (8 * i)) & 0xFF);
+			}
+		}
+		if (packet_type == TRANSFORMS_AND_INDICES) {
+			for (unsigned int i = 0; i < 4; i++) {
+				unsigned int bits;
+				memcpy(&bits, &positions[i], sizeof(bits));
+				for (unsigned int j = 0; j < PATH_POSITION_WIRE_SIZE; j++) {
+					data[size++] = (char)((bits >> (8 * j)) & 0xFF);
+				}
+			}
+		}
+		if (packet_type == UDP_CONNECT) {
+			for (unsigned int i = 0; i < UDP_TOKEN_SIZE; i++) {
+				data[size++] = (char)((token >> (8 * i)) & 0xFF);
+			}
+		}
+		return size;
     }
 
-    void deserialize(char * data) {
-        memcpy(this, data, sizeof(Packet));
+	/* Read the wire form back
+	 * returns false if length does not match the packet type
+	 */
+    bool deserialize(char * data, unsigned int length) {
+		if (length < 1) {
+			return false;
+		}
+		packet_type = (unsigned char)data[0];
+		if (length != wireSize(packet_type)) {
+			return false;
+		}
+
+		unsigned int size = 1;
+		if (packet_type == HEAD_HAND_TRANSFORMS || packet_type == TRANSFORMS_AND_INDICES) {
+			hand_transform = poseCodec().decode(data + size);
+			size += poseCodec().encodedSize();
+			head_transform = poseCodec().decode(data + size);
+			size += poseCodec().encodedSize();
+		}
+		if (packet_type == HEAD_HAND_TRANSFORMS) {
+			ack = (unsigned char)data[size] | ((unsigned char)data[size + 1] << 8);
+			size += ACK_WIRE_SIZE;
+			time = 0;
+			for (unsigned int i = 0; i < TIME_WIRE_SIZE; i++) {
+				time |= (unsigned int)(unsigned char)data[size++] << (8 * i);
+			}
+		}
+		if (packet_type == TRANSFORMS_AND_INDICES) {
+			for (unsigned int i = 0; i < 4; i++) {
+				unsigned int bits = 0;
+				for (unsigned int j = 0; j < PATH_POSITION_WIRE_SIZE; j++) {
+					bits |= (unsigned int)(unsigned char)data[size++] << (8 * j);
+				}
+				memcpy(&positions[i], &bits, sizeof(bits));
+			}
+		}
+		if (packet_type == UDP_CONNECT) {
+			token = 0;
+			for (unsigned int i = 0; i < UDP_TOKEN_SIZE; i++) {
+				token |= (unsigned int)(unsigned char)data[size++] << (8 * i);
+			}
+		}
+		return true;
     }
-};
\ No newline at end of file
+
+	/* Serialize with the frame header in front
+	 * data - receives at most FRAME_HEADER_SIZE + MAX_PACKET_WIRE_SIZE bytes
+	 * returns the size of the whole frame
+	 */
+	unsigned int serializeFrame(char * data) {
+		unsigned int size = serialize(data + FRAME_HEADER_SIZE);
+		writeFrameHeader(data, size);
+		return FRAME_HEADER_SIZE + size;
+	}
+};
+
+#define MAX_FRAMED_PACKET_SIZE (FRAME_HEADER_SIZE + MAX_PACKET_WIRE_SIZE)
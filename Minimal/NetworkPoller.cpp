@@ -0,0 +1,159 @@
+#include "stdafx.h"
+#include "NetworkPoller.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+// Upper bound on the epoll events fetched per wait
+#define MAX_POLL_EVENTS 64
+
+NetworkPoller * NetworkPoller::create()
+{
+#ifdef __linux__
+    return new EpollPoller();
+#else
+    return new SelectPoller();
+#endif
+}
+
+/*------------------ EPOLL -----------------*/
+#ifdef __linux__
+EpollPoller::EpollPoller()
+{
+    epoll_fd = epoll_create1(0);
+
+    if (epoll_fd < 0) {
+        printf("epoll_create1 failed with error: %d\n", errno);
+        exit(1);
+    }
+}
+
+EpollPoller::~EpollPoller()
+{
+    close(epoll_fd);
+}
+
+static unsigned int epollFlags(bool want_write)
+{
+    // Edge-triggered: a socket is only reported again once new data arrives after it was drained
+    unsigned int flags = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    if (want_write) {
+        flags |= EPOLLOUT;
+    }
+    return flags;
+}
+
+bool EpollPoller::add(SOCKET curSocket, bool want_write)
+{
+    struct epoll_event ev;
+    ev.events = epollFlags(want_write);
+    ev.data.fd = curSocket;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, curSocket, &ev) == 0;
+}
+
+bool EpollPoller::modify(SOCKET curSocket, bool want_write)
+{
+    struct epoll_event ev;
+    ev.events = epollFlags(want_write);
+    ev.data.fd = curSocket;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, curSocket, &ev) == 0;
+}
+
+void EpollPoller::remove(SOCKET curSocket)
+{
+    struct epoll_event ev;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, curSocket, &ev);
+}
+
+int EpollPoller::wait(PollEvent * events, int max_events, int timeout_ms)
+{
+    struct epoll_event ready[MAX_POLL_EVENTS];
+    if (max_events > MAX_POLL_EVENTS) {
+        max_events = MAX_POLL_EVENTS;
+    }
+
+    int count = epoll_wait(epoll_fd, ready, max_events, timeout_ms);
+    if (count < 0) {
+        // Interrupted by a signal is not an error, there is just nothing ready
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        events[i].socket = ready[i].data.fd;
+        events[i].events = 0;
+        if (ready[i].events & (EPOLLIN | EPOLLRDHUP)) events[i].events |= POLL_READ;
+        if (ready[i].events & EPOLLOUT) events[i].events |= POLL_WRITE;
+        if (ready[i].events & (EPOLLERR | EPOLLHUP)) events[i].events |= POLL_ERROR;
+    }
+    return count;
+}
+#endif
+
+/*------------------ SELECT -----------------*/
+bool SelectPoller::add(SOCKET curSocket, bool want_write)
+{
+    watched[curSocket] = want_write;
+    return true;
+}
+
+bool SelectPoller::modify(SOCKET curSocket, bool want_write)
+{
+    std::map<SOCKET, bool>::iterator iter = watched.find(curSocket);
+    if (iter == watched.end()) {
+        return false;
+    }
+    iter->second = want_write;
+    return true;
+}
+
+void SelectPoller::remove(SOCKET curSocket)
+{
+    watched.erase(curSocket);
+}
+
+int SelectPoller::wait(PollEvent * events, int max_events, int timeout_ms)
+{
+    fd_set read_set, write_set, error_set;
+    FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
+    FD_ZERO(&error_set);
+
+    SOCKET max_socket = 0;
+    std::map<SOCKET, bool>::iterator iter;
+    for (iter = watched.begin(); iter != watched.end(); iter++) {
+        FD_SET(iter->first, &read_set);
+        FD_SET(iter->first, &error_set);
+        if (iter->second) {
+            FD_SET(iter->first, &write_set);
+        }
+        if (iter->first > max_socket) {
+            max_socket = iter->first;
+        }
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    // nfds is ignored by Winsock
+    int result = select((int)max_socket + 1, &read_set, &write_set, &error_set, timeout_ms < 0 ? NULL : &timeout);
+    if (result <= 0) {
+        return result;
+    }
+
+    int count = 0;
+    for (iter = watched.begin(); iter != watched.end() && count < max_events; iter++) {
+        unsigned int flags = 0;
+        if (FD_ISSET(iter->first, &read_set)) flags |= POLL_READ;
+        if (FD_ISSET(iter->first, &write_set)) flags |= POLL_WRITE;
+        if (FD_ISSET(iter->first, &error_set)) flags |= POLL_ERROR;
+
+        if (flags) {
+            events[count].socket = iter->first;
+            events[count].events = flags;
+            count++;
+        }
+    }
+    return count;
+}
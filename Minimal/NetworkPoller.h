@@ -0,0 +1,73 @@
+/* Socket readiness notification. Linux uses an edge-triggered epoll set, other platforms fall back to select()
+ * Callers must drain a socket (read/write until it would block) every time it is reported, which is correct for both
+ */
+#pragma once
+#include "NetworkServices.h"
+#include <map>
+
+// Readiness flags reported by NetworkPoller::wait
+#define POLL_READ	(1 << 0)
+#define POLL_WRITE	(1 << 1)
+#define POLL_ERROR	(1 << 2)
+
+struct PollEvent
+{
+	SOCKET socket;
+	unsigned int events;	// POLL_* flags
+};
+
+class NetworkPoller
+{
+public:
+	virtual ~NetworkPoller() {}
+
+	/* Start watching a (nonblocking) socket for reads
+	 * curSocket - socket to watch
+	 * want_write - also report when the socket becomes writable
+	 */
+	virtual bool add(SOCKET curSocket, bool want_write) = 0;
+	// Change whether writability is reported for a watched socket
+	virtual bool modify(SOCKET curSocket, bool want_write) = 0;
+	virtual void remove(SOCKET curSocket) = 0;
+
+	/* Wait for readiness on the watched sockets
+	 * events - filled with the ready sockets
+	 * max_events - size of events
+	 * timeout_ms - how long to block (0 returns immediately, -1 waits forever)
+	 * returns the number of events filled in, or -1 on error
+	 */
+	virtual int wait(PollEvent * events, int max_events, int timeout_ms) = 0;
+
+	// Best poller available on this platform
+	static NetworkPoller * create();
+};
+
+#ifdef __linux__
+class EpollPoller : public NetworkPoller
+{
+public:
+	EpollPoller();
+	~EpollPoller();
+
+	bool add(SOCKET curSocket, bool want_write);
+	bool modify(SOCKET curSocket, bool want_write);
+	void remove(SOCKET curSocket);
+	int wait(PollEvent * events, int max_events, int timeout_ms);
+
+private:
+	int epoll_fd;
+};
+#endif
+
+class SelectPoller : public NetworkPoller
+{
+public:
+	bool add(SOCKET curSocket, bool want_write);
+	bool modify(SOCKET curSocket, bool want_write);
+	void remove(SOCKET curSocket);
+	int wait(PollEvent * events, int max_events, int timeout_ms);
+
+private:
+	// Watched sockets and whether writability is wanted
+	std::map<SOCKET, bool> watched;
+};
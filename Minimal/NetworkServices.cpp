@@ -1,12 +1,97 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "NetworkServices.h"
 
+int NetworkServices::initialize()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2,2), &wsaData);
+#else
+    return 0;
+#endif
+}
+
+void NetworkServices::cleanup()
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
 int NetworkServices::sendMessage(SOCKET curSocket, char * message, int messageSize)
 {
+#ifdef _WIN32
     return send(curSocket, message, messageSize, 0);
+#else
+    // don't let a dropped peer kill the process with SIGPIPE
+    return (int)send(curSocket, message, messageSize, MSG_NOSIGNAL);
+#endif
 }
 
 int NetworkServices::receiveMessage(SOCKET curSocket, char * buffer, int bufSize)
 {
-    return recv(curSocket, buffer, bufSize, 0);
-}
\ No newline at end of file
+    return (int)recv(curSocket, buffer, bufSize, 0);
+}
+
+int NetworkServices::sendDatagram(SOCKET curSocket, char * message, int messageSize, const sockaddr * address, socklen_t addressSize)
+{
+    return (int)sendto(curSocket, message, messageSize, 0, address, addressSize);
+}
+
+int NetworkServices::receiveDatagram(SOCKET curSocket, char * buffer, int bufSize, sockaddr_storage * address, socklen_t * addressSize)
+{
+    *addressSize = sizeof(sockaddr_storage);
+    return (int)recvfrom(curSocket, buffer, bufSize, 0, (sockaddr *)address, addressSize);
+}
+
+int NetworkServices::closeSocket(SOCKET curSocket)
+{
+#ifdef _WIN32
+    return closesocket(curSocket);
+#else
+    return close(curSocket);
+#endif
+}
+
+int NetworkServices::setNonBlocking(SOCKET curSocket)
+{
+#ifdef _WIN32
+    u_long iMode = 1;
+    return ioctlsocket(curSocket, FIONBIO, &iMode);
+#else
+    int flags = fcntl(curSocket, F_GETFL, 0);
+    if (flags < 0)
+    {
+        return SOCKET_ERROR;
+    }
+    return fcntl(curSocket, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+int NetworkServices::disableNagle(SOCKET curSocket)
+{
+#ifdef _WIN32
+    char value = 1;
+#else
+    int value = 1;
+#endif
+    return setsockopt(curSocket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+}
+
+int NetworkServices::getLastError()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool NetworkServices::wouldBlock(int error)
+{
+#ifdef _WIN32
+    return error == WSAEWOULDBLOCK;
+#else
+    return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+}
@@ -1,11 +1,46 @@
 #pragma once
+#ifdef _WIN32
 #include <winsock2.h>
 #include <Windows.h>
+#include <ws2tcpip.h>
+#pragma comment (lib, "Ws2_32.lib")
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 
+// Use the Winsock names for POSIX sockets so the rest of the networking code is shared
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#endif
+
+/* Thin platform layer over Winsock / BSD sockets */
 class NetworkServices
 {
 public:
+	// Start up the socket library (WSAStartup on Windows). Returns 0 on success
+	static int initialize();
+	static void cleanup();
+
 	static int sendMessage(SOCKET curSocket, char * message, int messageSize);
 	static int receiveMessage(SOCKET curSocket, char * buffer, int bufSize);
-};
 
+	// UDP. receiveDatagram fills in the sender's address
+	static int sendDatagram(SOCKET curSocket, char * message, int messageSize, const sockaddr * address, socklen_t addressSize);
+	static int receiveDatagram(SOCKET curSocket, char * buffer, int bufSize, sockaddr_storage * address, socklen_t * addressSize);
+
+	static int closeSocket(SOCKET curSocket);
+	static int setNonBlocking(SOCKET curSocket);
+	static int disableNagle(SOCKET curSocket);
+
+	// Error code of the last failed socket call
+	static int getLastError();
+	// True if the error only means the call would have blocked
+	static bool wouldBlock(int error);
+};
@@ -28,11 +28,12 @@
 #include <vector>
 
 #include "Shader.h"
+#include "RenderContext.h"
 
 class Node {
 public:
-	// Will add transformations down the object graph path
-	virtual void draw(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C) = 0;
+	// Will add transformations down the object graph path (draws with context.shader at context.transforms.top())
+	virtual void draw(RenderContext & context) = 0;
 
 	// Do not know of a function for this quite yet
 	virtual void update() = 0;
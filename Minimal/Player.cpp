@@ -29,8 +29,8 @@ Player::Player(Model * head, Model * hand, Model * sword, bool playerType) {
 void Player::initialize() {
 	// Resize and rotate
 	models[RIGHT_HAND]->scale(0.5f);
-	models[SWORD]->scale(1.4f);
-	sword_scale_factor = 1.4f;
+	models[SWORD]->scale(SWORD_SCALE);
+	sword_scale_factor = SWORD_SCALE;
 	models[SWORD]->rotate(45.0f, vec3(0, 1.0f, 0));
 	models[SWORD]->rotate(20.0f, vec3(1.0f, 0, 0));
 	models[SWORD]->translate(vec3(0.09f, 0.06f, -0.13f));	// Coordinate system of sword has been rotated slightly. This is a hacky fix. I do not know how to fix, yet
@@ -38,17 +38,9 @@ void Player::initialize() {
 	models[HEAD]->rotate(90.0f, vec3(0, 1.0f, 0));
 	models[HEAD]->translate(vec3(0, 0, 0.15f));
 	
-	// Create bounding box
-	
-	vec3 box_size = glm::scale(mat4(1.0f), vec3(sword_scale_factor)) * vec4(models[SWORD]->getBoxDimensions(), 1.0f);
-	//vec3 box_size = models[SWORD]->getBoxDimensions();
-	attack_box = new Bound(box_size.x /4.0f, box_size.y /4.0f, box_size.z / 4.0f);
-	attack_box->toWorld = glm::translate(mat4(1.0f), vec3(0.002f, 0.27f, -0.39f)) *
-							glm::rotate(glm::mat4(1.0f), 33.0f / 180.0f * glm::pi<float>(), vec3(1.0f, 0, 0)) 
-							* glm::rotate(glm::mat4(1.0f), 90.0f / 180.0f * glm::pi<float>(), vec3(0, 1.0f, 0));
-	
-
-
+	// Create bounding box (same box the game logic tests hits with)
+	sword_box_size = glm::scale(mat4(1.0f), vec3(sword_scale_factor)) * vec4(models[SWORD]->getBoxDimensions(), 1.0f);
+	attack_box = GameLogic::createSwordBox(sword_box_size);
 }
 
 Player::~Player() {
@@ -70,29 +62,47 @@ float Player::getSwordScaleFactor() {
 	return sword_scale_factor;
 }
 
+vec3 Player::getSwordBoxSize() {
+	return sword_box_size;
+}
+
 void Player::updateBoundingBox(mat4 transform_mat) {
 	attack_box->update(transform_mat);
 }
 
 bool Player::checkHit(Bound * toCompare) {
-	return attack_box->check_collision(toCompare);
+	return attack_box->check_swept_collision(toCompare);
 }
 
-void Player::drawPlayer(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 handTransform, glm::mat4 headTransform) {
-	// Send info to shader to discriminate between players
-	shader.setInt(std::string("which_player"), playerType);
-	// Render player 
-	models[RIGHT_HAND]->draw(shader, P, V, handTransform);
-	models[SWORD]->draw(shader, P, V, handTransform);
-	models[HEAD]->draw(shader, P, V, headTransform);
+void Player::addToScene(SceneGraph & scene) {
+	hand_node = scene.add(mat4(1.0f));
+	head_node = scene.add(mat4(1.0f));
+	// Model nodes after both parents, so the draw reads them back to back
+	model_nodes[HEAD] = scene.add(models[HEAD]->getToWorld(), head_node);
+	model_nodes[RIGHT_HAND] = scene.add(models[RIGHT_HAND]->getToWorld(), hand_node);
+	model_nodes[SWORD] = scene.add(models[SWORD]->getToWorld(), hand_node);
+}
+
+void Player::updateScene(SceneGraph & scene, const mat4 & handTransform, const mat4 & headTransform) {
+	scene.setLocal(hand_node, handTransform);
+	scene.setLocal(head_node, headTransform);
+}
+
+void Player::drawPlayer(const RenderContext & context, const SceneGraph & scene) {
+	// Render player (which_player lets the shader discriminate between players)
+	for (unsigned int i = 0; i < models.size(); i++) {
+		models[i]->drawAt(context, scene.world(model_nodes[i]), playerType);
+	}
 }
 
-void Player::drawBoundingBox(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 handTransform) {
+void Player::drawBoundingBox(RenderContext & context, const mat4 & handTransform) {
 	// Check if sword bounding box exists
 	if (attack_box == NULL) {
 		std::cout << "Player " << playerType << "'s bounding box has not been initialize!" << std::endl;
 		return;
 	}
 
-	attack_box->draw(shader.ID, P, V, handTransform);
+	context.transforms.push(handTransform);
+	attack_box->draw(context);
+	context.transforms.pop();
 }
\ No newline at end of file
@@ -27,6 +27,8 @@
 
 #include "Model.h"
 #include "Bound.h"
+#include "GameLogic.h"
+#include "SceneGraph.h"
 
 class Player {
 public:
@@ -44,18 +46,26 @@ public:
 	int getScore();
 	// TODO: Add function to handle sword hits here
 
-	/* Player render function
-	 * shader - glsl shader to send vertex and other info to for gfx
-	 * P - projection matrix
-	 * V - view matrix
+	/* Add the player's hand and head transforms to the scene, with the hand, sword and head models under them
+	 * scene - scene graph holding the players and the treasure
+	 */
+	void addToScene(SceneGraph & scene);
+	/* Move the player's hand and head in the scene (the models under them follow on the next scene update)
+	 * scene - the scene graph the player was added to
 	 * handTransform - hand transformation matrix
 	 * headTransform - head transformation matrix
 	 */
-	void drawPlayer(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 handTransform, glm::mat4 headTransform);
-	void drawPlayer(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 hand_translate, glm::mat4 hand_rotate, glm::mat4 headTransform);
-	void drawBoundingBox(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 handTransform);
+	void updateScene(SceneGraph & scene, const glm::mat4 & handTransform, const glm::mat4 & headTransform);
+	/* Player render function, draws the models at their cached world matrices
+	 * context - render state of the pass (shader to send vertex and other info to for gfx)
+	 * scene - the scene graph the player was added to
+	 */
+	void drawPlayer(const RenderContext & context, const SceneGraph & scene);
+	void drawBoundingBox(RenderContext & context, const glm::mat4 & handTransform);
 
 	float getSwordScaleFactor();
+	// Dimensions of the scaled sword model (what the sword hitbox is built from)
+	glm::vec3 getSwordBoxSize();
 	void updateBoundingBox(glm::mat4 transform_mat);
 	bool checkHit(Bound * toCompare);
 
@@ -64,8 +74,12 @@ private:
 	unsigned int score;
 	unsigned int playerType;
 	float sword_scale_factor;		// Contains sword scale factor
+	glm::vec3 sword_box_size;		// Scaled sword model dimensions
 	std::vector<Model *> models;	// Will store pointers to head and hand(s)
 	Bound * attack_box = NULL;		// Sword hitbox
+	unsigned int hand_node;			// Scene node following the hand
+	unsigned int head_node;			// Scene node following the head
+	unsigned int model_nodes[3];	// Scene node of each model (under the hand or head node)
 
 	/* Private Functions */
 	void initialize();	// Resize and rotate everything to the correct position
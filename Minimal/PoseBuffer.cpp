@@ -0,0 +1,123 @@
+#include "PoseBuffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <math.h>
+
+// Smoothing of the interval/jitter averages and how fast the clock offset may drift up
+#define POSE_AVERAGE_WEIGHT 0.1
+#define POSE_OFFSET_RELAX 0.002
+
+using glm::mat4;
+using glm::quat;
+using glm::vec3;
+
+PoseBuffer::PoseBuffer(double max_extrapolation) {
+	this->max_extrapolation = max_extrapolation;
+	count = 0;
+	newest = 0;
+	last_raw_ms = 0;
+	last_sender_time = 0.0;
+	clock_offset = 0.0;
+	interval = 1.0 / 90.0;
+	jitter = 0.0;
+}
+
+double PoseBuffer::localTime() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned int PoseBuffer::timestampMs() {
+	return (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double PoseBuffer::playoutDelay() {
+	double delay = 1.5 * interval + 2.0 * jitter;
+	return delay < POSE_MIN_DELAY ? POSE_MIN_DELAY : (delay > POSE_MAX_DELAY ? POSE_MAX_DELAY : delay);
+}
+
+void PoseBuffer::push(unsigned int sender_time_ms, double arrival_time, const mat4 & hand, const mat4 & head) {
+	// Unwrap the millisecond clock against the last accepted pose
+	double sender_time = count == 0 ? 0.0 : last_sender_time + (int)(sender_time_ms - last_raw_ms) / 1000.0;
+	if (count > 0 && sender_time <= samples[newest].time) {
+		return;
+	}
+
+	double transit = arrival_time - sender_time;
+	if (count == 0) {
+		clock_offset = transit;
+	}
+	else {
+		interval += (sender_time - samples[newest].time - interval) * POSE_AVERAGE_WEIGHT;
+
+		// The fastest pose bounds the offset between the clocks. Let it creep up so route changes and clock drift recover
+		if (transit < clock_offset) {
+			clock_offset = transit;
+		}
+		else {
+			clock_offset += (transit - clock_offset) * POSE_OFFSET_RELAX;
+		}
+		jitter += (transit - clock_offset - jitter) * POSE_AVERAGE_WEIGHT;
+	}
+	last_raw_ms = sender_time_ms;
+	last_sender_time = sender_time;
+
+	newest = (newest + 1) % POSE_BUFFER_SIZE;
+	PoseSample & pose = samples[newest];
+	pose.time = sender_time;
+	pose.hand_position = vec3(hand[3]);
+	pose.hand_rotation = glm::quat_cast(hand);
+	pose.head_position = vec3(head[3]);
+	pose.head_rotation = glm::quat_cast(head);
+	if (count < POSE_BUFFER_SIZE) {
+		count++;
+	}
+}
+
+void PoseBuffer::blend(const PoseSample & a, const PoseSample & b, float t, mat4 & hand, mat4 & head) {
+	hand = glm::mat4_cast(glm::normalize(glm::slerp(a.hand_rotation, b.hand_rotation, t)));
+	hand[3] = glm::vec4(glm::mix(a.hand_position, b.hand_position, t), 1.0f);
+	head = glm::mat4_cast(glm::normalize(glm::slerp(a.head_rotation, b.head_rotation, t)));
+	head[3] = glm::vec4(glm::mix(a.head_position, b.head_position, t), 1.0f);
+}
+
+bool PoseBuffer::sample(double local_time, mat4 & hand, mat4 & head) {
+	if (count == 0) {
+		return false;
+	}
+
+	// Render time on the sender's clock
+	double t = local_time - clock_offset - playoutDelay();
+	const PoseSample & latest = samples[newest];
+
+	// Nothing newer yet: dead reckon from the last two poses, but not too far
+	if (t >= latest.time) {
+		if (count < 2) {
+			blend(latest, latest, 0.0f, hand, head);
+			return true;
+		}
+		const PoseSample & previous = samples[(newest + POSE_BUFFER_SIZE - 1) % POSE_BUFFER_SIZE];
+		double ahead = t - latest.time;
+		if (ahead > max_extrapolation) {
+			ahead = max_extrapolation;
+		}
+		blend(previous, latest, (float)(1.0 + ahead / (latest.time - previous.time)), hand, head);
+		return true;
+	}
+
+	// Find the two poses around the render time, newest first
+	unsigned int after = newest;
+	for (unsigned int i = 1; i < count; i++) {
+		unsigned int before = (newest + POSE_BUFFER_SIZE - i) % POSE_BUFFER_SIZE;
+		if (samples[before].time <= t) {
+			const PoseSample & a = samples[before];
+			const PoseSample & b = samples[after];
+			blend(a, b, (float)((t - a.time) / (b.time - a.time)), hand, head);
+			return true;
+		}
+		after = before;
+	}
+
+	// Older than anything kept
+	blend(samples[after], samples[after], 0.0f, hand, head);
+	return true;
+}
@@ -0,0 +1,72 @@
+/* Jitter buffer for a remote player's head and hand poses
+ * Poses are stamped with the sender's clock. The buffer plays them back a short, adaptive delay behind the
+ * newest one. It interpolates between the two samples around the render time (lerp position, slerp rotation)
+ * and, when the next sample is late, extrapolates from the last two for at most max_extrapolation seconds.
+ */
+#pragma once
+#ifndef _POSE_BUFFER_H_
+#define _POSE_BUFFER_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#define POSE_BUFFER_SIZE 32
+// Bounds of the playout delay, which follows the sender's interval and the network jitter
+#define POSE_MIN_DELAY 0.02
+#define POSE_MAX_DELAY 0.2
+#define POSE_MAX_EXTRAPOLATION 0.1
+
+struct PoseSample {
+	double time;					// Sender clock, seconds
+	glm::vec3 hand_position;
+	glm::quat hand_rotation;
+	glm::vec3 head_position;
+	glm::quat head_rotation;
+};
+
+class PoseBuffer {
+public:
+	PoseBuffer(double max_extrapolation = POSE_MAX_EXTRAPOLATION);
+
+	/* Add a received pose. Late or duplicate poses are ignored
+	 * sender_time_ms - sender's timestamp (PoseBuffer::timestampMs on the sending machine)
+	 * arrival_time - local time it arrived (PoseBuffer::localTime)
+	 */
+	void push(unsigned int sender_time_ms, double arrival_time, const glm::mat4 & hand, const glm::mat4 & head);
+
+	/* Pose to show at a local time
+	 * returns false until the first pose has arrived
+	 */
+	bool sample(double local_time, glm::mat4 & hand, glm::mat4 & head);
+
+	// Seconds the playback runs behind the newest pose
+	double playoutDelay();
+
+	// Local clock in seconds, for arrival and render times
+	static double localTime();
+	// Clock stamped on outgoing poses (milliseconds, wraps around)
+	static unsigned int timestampMs();
+
+private:
+	PoseSample samples[POSE_BUFFER_SIZE];
+	unsigned int count;
+	unsigned int newest;
+	double max_extrapolation;
+
+	// Sender timestamps are unwrapped into seconds relative to the first one
+	unsigned int last_raw_ms;
+	double last_sender_time;
+
+	double clock_offset;		// Local minus sender time of the fastest pose so far (relaxes upward slowly)
+	double interval;			// Average time between sender poses
+	double jitter;				// Average extra transit time over the fastest pose
+
+	// Pose a fraction t of the way from a to b (t > 1 extrapolates)
+	static void blend(const PoseSample & a, const PoseSample & b, float t, glm::mat4 & hand, glm::mat4 & head);
+};
+
+#endif
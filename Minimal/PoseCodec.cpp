@@ -0,0 +1,112 @@
+#include "PoseCodec.h"
+#include <math.h>
+
+// Range of the three smallest components of a unit quaternion
+#define SMALLEST_THREE_RANGE 0.70710678f
+
+// Fixed-point positions are signed shorts
+#define POSITION_MIN -32768
+#define POSITION_MAX 32767
+
+using glm::mat4;
+using glm::quat;
+using glm::vec4;
+
+PoseCodec::PoseCodec(float position_precision, unsigned int rotation_bits) {
+	if (rotation_bits < 2) rotation_bits = 2;
+	if (rotation_bits > POSE_MAX_ROTATION_BITS) rotation_bits = POSE_MAX_ROTATION_BITS;
+
+	this->position_precision = position_precision;
+	this->rotation_bits = rotation_bits;
+}
+
+unsigned int PoseCodec::rotationSize() const {
+	return (2 + 3 * rotation_bits + 7) / 8;
+}
+
+unsigned int PoseCodec::encodedSize() const {
+	return 3 * sizeof(short) + rotationSize();
+}
+
+/*------------------------ ROTATION ---------------------------*/
+unsigned int PoseCodec::encodeRotation(quat rotation, char * data) const {
+	// Find the largest component, it is the one left out
+	unsigned int largest = 0;
+	for (unsigned int i = 1; i < 4; i++) {
+		if (fabsf(rotation[i]) > fabsf(rotation[largest])) {
+			largest = i;
+		}
+	}
+
+	// q and -q are the same rotation. Flip so the dropped component is positive
+	float sign = rotation[largest] < 0.0f ? -1.0f : 1.0f;
+	unsigned long long max_value = (1ULL << rotation_bits) - 1;
+
+	unsigned long long bits = largest;
+	for (unsigned int i = 0; i < 4; i++) {
+		if (i == largest) {
+			continue;
+		}
+		float normalized = (rotation[i] * sign + SMALLEST_THREE_RANGE) / (2.0f * SMALLEST_THREE_RANGE);
+		normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+		bits = (bits << rotation_bits) | (unsigned long long)(normalized * max_value + 0.5f);
+	}
+
+	// Little-endian
+	unsigned int size = rotationSize();
+	for (unsigned int i = 0; i < size; i++) {
+		data[i] = (char)((bits >> (8 * i)) & 0xFF);
+	}
+	return size;
+}
+
+quat PoseCodec::decodeRotation(const char * data) const {
+	unsigned long long bits = 0;
+	unsigned int size = rotationSize();
+	for (unsigned int i = 0; i < size; i++) {
+		bits |= (unsigned long long)(unsigned char)data[i] << (8 * i);
+	}
+
+	unsigned long long max_value = (1ULL << rotation_bits) - 1;
+	unsigned int largest = (unsigned int)(bits >> (3 * rotation_bits)) & 3;
+
+	quat rotation;
+	float sum = 0.0f;
+	// Components were packed first to last, so unpack last to first
+	for (int i = 3; i >= 0; i--) {
+		if (i == (int)largest) {
+			continue;
+		}
+		float normalized = (float)(bits & max_value) / max_value;
+		bits >>= rotation_bits;
+		rotation[i] = normalized * 2.0f * SMALLEST_THREE_RANGE - SMALLEST_THREE_RANGE;
+		sum += rotation[i] * rotation[i];
+	}
+	rotation[largest] = sqrtf(sum < 1.0f ? 1.0f - sum : 0.0f);
+
+	return glm::normalize(rotation);
+}
+
+/*------------------------ POSE ---------------------------*/
+unsigned int PoseCodec::encode(const mat4 & pose, char * data) const {
+	for (unsigned int i = 0; i < 3; i++) {
+		float steps = floorf(pose[3][i] / position_precision + 0.5f);
+		steps = steps < POSITION_MIN ? POSITION_MIN : (steps > POSITION_MAX ? POSITION_MAX : steps);
+
+		unsigned short value = (unsigned short)(short)steps;
+		data[2 * i] = (char)(value & 0xFF);
+		data[2 * i + 1] = (char)(value >> 8);
+	}
+
+	return 3 * sizeof(short) + encodeRotation(glm::quat_cast(pose), data + 3 * sizeof(short));
+}
+
+mat4 PoseCodec::decode(const char * data) const {
+	mat4 pose = glm::mat4_cast(decodeRotation(data + 3 * sizeof(short)));
+
+	for (unsigned int i = 0; i < 3; i++) {
+		unsigned short value = (unsigned short)((unsigned char)data[2 * i] | ((unsigned char)data[2 * i + 1] << 8));
+		pose[3][i] = (short)value * position_precision;
+	}
+	return pose;
+}
@@ -0,0 +1,55 @@
+/* Compact network encoding of rigid poses (head and hand transforms)
+ * Rotation is sent as a smallest-three quaternion: 2 bits for the index of the largest component, which is
+ * dropped and rebuilt from the unit length, and rotation_bits for each of the other three.
+ * Position is sent as a 16 bit fixed-point number per axis, in steps of position_precision meters.
+ */
+#pragma once
+#ifndef _POSE_CODEC_H_
+#define _POSE_CODEC_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Default precision (both ends must use the same)
+#define POSE_POSITION_PRECISION (1.0f / 2048.0f)	// 0.5 mm steps, +/- 16 m range
+#define POSE_ROTATION_BITS 12						// < 0.1 degree worst-case error, rotation fits in 5 bytes
+#define POSE_MAX_ROTATION_BITS 20
+
+// Largest encoded pose (3 position shorts + 2 + 3 * POSE_MAX_ROTATION_BITS bits)
+#define POSE_MAX_ENCODED_SIZE (6 + 8)
+
+class PoseCodec {
+public:
+	/* PoseCodec constructor
+	 * position_precision - size of one position step in meters
+	 * rotation_bits - bits per quaternion component (clamped to 2..POSE_MAX_ROTATION_BITS)
+	 */
+	PoseCodec(float position_precision = POSE_POSITION_PRECISION, unsigned int rotation_bits = POSE_ROTATION_BITS);
+
+	// Bytes written per pose
+	unsigned int encodedSize() const;
+
+	/* Encode a rotation + translation matrix
+	 * pose - rigid transform (no scale)
+	 * data - receives encodedSize() bytes
+	 * returns the number of bytes written
+	 */
+	unsigned int encode(const glm::mat4 & pose, char * data) const;
+	glm::mat4 decode(const char * data) const;
+
+	unsigned int encodeRotation(glm::quat rotation, char * data) const;
+	glm::quat decodeRotation(const char * data) const;
+
+private:
+	float position_precision;
+	unsigned int rotation_bits;
+
+	// Bytes used by the rotation
+	unsigned int rotationSize() const;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/* Per-pass render state handed down the scene by reference
+ * renderScene fills one of these per pass (per eye, or once with single-pass stereo) and every draw
+ * function reads the shader and its model matrix from it instead of taking copies of them.
+ * Models add their meshes to the pass's render queue, which draws them sorted by state at the end.
+ */
+#pragma once
+#ifndef _RENDER_CONTEXT_H_
+#define _RENDER_CONTEXT_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+#include "Shader.h"
+#include "Frustum.h"
+#include "RenderQueue.h"
+
+// Stack space reserved up front, deeper graphs still work but grow the stack once
+#define TRANSFORM_STACK_RESERVE 16
+
+/* Model matrices accumulated on the way down the scene graph. The top is the transform the next draw
+ * is placed with. Pushing M puts M * top on the stack (the order Transform nodes always used)
+ */
+class TransformStack {
+public:
+	TransformStack() {
+		stack.reserve(TRANSFORM_STACK_RESERVE);
+		stack.push_back(glm::mat4(1.0f));
+	}
+
+	const glm::mat4 & top() const { return stack.back(); }
+	void push(const glm::mat4 & M) { stack.push_back(M * stack.back()); }
+	void pop() {
+		if (stack.size() > 1) {
+			stack.pop_back();
+		}
+		else {
+			printf("TransformStack: pop without a matching push!\n");
+		}
+	}
+	// Back to just the identity (start of a pass)
+	void reset() { stack.resize(1); }
+
+private:
+	std::vector<glm::mat4> stack;
+};
+
+struct RenderContext {
+	glm::mat4 projection;			// Projection of the pass (the left eye's with single-pass stereo)
+	glm::mat4 view;					// View of the pass (likewise)
+	Frustum frustum;				// What the pass can see (both eyes with single-pass stereo), for culling
+	const Shader * shader = NULL;	// Shader the draws go through, set with use() or select()
+	TransformStack transforms;		// Model transform of whatever is drawn next
+	RenderQueue * queue = NULL;		// Where models queue their meshes (required to draw models)
+
+	/* Start drawing with another shader
+	 * next - shader to bind
+	 */
+	void use(const Shader & next) {
+		shader = &next;
+		next.use();
+	}
+	/* Queue the next models with another shader (the queue binds it when they are submitted)
+	 * next - shader the queued draws go through
+	 */
+	void select(const Shader & next) {
+		shader = &next;
+	}
+};
+
+#endif
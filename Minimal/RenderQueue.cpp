@@ -0,0 +1,121 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+// Width of each key field (they add up to 64)
+#define KEY_PASS_BITS 4
+#define KEY_SHADER_BITS 12
+#define KEY_MATERIAL_BITS 16
+#define KEY_DEPTH_BITS 32
+
+// Nothing is bound yet, so the first item changes all state
+#define NO_STATE 0xFFFFFFFF
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+RenderQueue::RenderQueue() : pass(RENDER_PASS_OPAQUE) {
+
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+static uint64_t keyField(uint64_t value, unsigned int bits) {
+	return value & ((uint64_t(1) << bits) - 1);
+}
+
+uint64_t RenderQueue::sortKey(RenderPass pass, const Shader & shader, const Mesh & mesh, float distance) {
+	float depth = std::min(std::max(distance / RENDER_QUEUE_DEPTH_RANGE, 0.0f), 1.0f);
+	uint64_t key = keyField(pass, KEY_PASS_BITS);
+	key = (key << KEY_SHADER_BITS) | keyField(shader.ID, KEY_SHADER_BITS);
+	key = (key << KEY_MATERIAL_BITS) | keyField(mesh.material, KEY_MATERIAL_BITS);
+	key = (key << KEY_DEPTH_BITS) | keyField((uint64_t)(depth * (double)((uint64_t(1) << KEY_DEPTH_BITS) - 1)), KEY_DEPTH_BITS);
+	return key;
+}
+
+/*------------------------ QUEUE FUNCTIONS ---------------------------*/
+void RenderQueue::add(const Shader & shader, Mesh & mesh, const glm::mat4 & model, float distance, GLint which_player) {
+	RenderItem item;
+	item.key = sortKey(pass, shader, mesh, distance);
+	item.shader = &shader;
+	item.mesh = &mesh;
+	item.which_player = which_player;
+	item.first_matrix = (GLuint)matrices.size();
+	item.instances = 1;
+	items.push_back(item);
+	matrices.push_back(model);
+}
+
+GLuint RenderQueue::addMatrices(const std::vector<glm::mat4> & copies) {
+	GLuint first = (GLuint)matrices.size();
+	matrices.insert(matrices.end(), copies.begin(), copies.end());
+	return first;
+}
+
+void RenderQueue::addInstanced(const Shader & shader, Mesh & mesh, GLuint first_matrix, unsigned int instances) {
+	RenderItem item;
+	item.key = sortKey(pass, shader, mesh, 0.0f);
+	item.shader = &shader;
+	item.mesh = &mesh;
+	item.which_player = -1;
+	item.first_matrix = first_matrix;
+	item.instances = instances;
+	items.push_back(item);
+}
+
+unsigned int RenderQueue::size() const {
+	return (unsigned int)items.size();
+}
+
+void RenderQueue::submit() {
+	std::sort(items.begin(), items.end(), [](const RenderItem & a, const RenderItem & b) { return a.key < b.key; });
+
+	// One command per item, in draw order, uploaded with the matrices in one go
+	commands.resize(items.size());
+	for (unsigned int i = 0; i < items.size(); i++) {
+		const RenderItem & item = items[i];
+		DrawCommand & command = commands[i];
+		command.index_count = item.mesh->range.index_count;
+		command.instance_count = stereoInstances(item.instances);
+		command.first_index = item.mesh->range.first_index;
+		command.base_vertex = item.mesh->range.base_vertex;
+		command.base_instance = item.first_matrix;
+	}
+	GeometryArena & arena = geometryArena();
+	arena.upload(matrices, commands);
+
+	unsigned int program = NO_STATE;
+	unsigned int material = NO_STATE;
+	GLint which_player = -1;
+	unsigned int run_start = 0;
+	for (unsigned int i = 0; i < items.size(); i++) {
+		RenderItem & item = items[i];
+		if (item.shader->ID != program) {
+			item.shader->use();
+			program = item.shader->ID;
+			// Sampler and player uniforms belong to the program, set them again
+			material = NO_STATE;
+			which_player = -1;
+			renderStateChanges()++;
+		}
+		if (item.mesh->material != material) {
+			item.mesh->bindTextures(*item.shader);
+			material = item.mesh->material;
+			renderStateChanges()++;
+		}
+		if (item.which_player != which_player && item.which_player >= 0) {
+			item.shader->setInt(UNIFORM_WHICH_PLAYER, item.which_player);
+			which_player = item.which_player;
+		}
+
+		// The run goes out in one draw once the next item needs different state (the arena binds its own vertex array)
+		bool run_ends = i + 1 == items.size();
+		if (!run_ends) {
+			const RenderItem & next = items[i + 1];
+			run_ends = next.shader->ID != program || next.mesh->material != material ||
+				(next.which_player >= 0 && next.which_player != which_player);
+		}
+		if (run_ends) {
+			arena.draw(commands, run_start, i + 1 - run_start);
+			run_start = i + 1;
+		}
+	}
+	items.clear();
+	matrices.clear();
+}
@@ -0,0 +1,98 @@
+/* Render queue: draws are collected during the scene walk, sorted once by state, then submitted
+ * Each item gets a 64-bit key, most significant field first:
+ *   pass (4 bits) | shader (12 bits) | material (16 bits) | depth (32 bits)
+ * so after sorting, items sharing a program, then textures are next to each other and submit() only
+ * changes state between them when the key field actually changes. Within the same state, nearer items
+ * go first so the depth test rejects more of what is behind them.
+ * All meshes live in the geometry arena (GeometryArena.h) and share its vertex array, so the key has no
+ * vertex array field. Each run of items sharing a program and textures goes out as one multi draw,
+ * their model matrices read from the arena's draw matrix buffer.
+ */
+#pragma once
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <stdint.h>
+#include <vector>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "GeometryArena.h"
+
+// View distance that maps to the largest depth key (anything further sorts last, in any order)
+#define RENDER_QUEUE_DEPTH_RANGE 100.0f
+
+// Passes are submitted in this order
+enum RenderPass {
+	RENDER_PASS_OPAQUE,
+	NUM_RENDER_PASSES
+};
+
+// Program and texture switches submit() made since it was last reset
+inline unsigned int & renderStateChanges() {
+	static unsigned int count = 0;
+	return count;
+}
+
+struct RenderItem {
+	uint64_t key;
+	const Shader * shader;
+	Mesh * mesh;
+	GLint which_player;			// which_player uniform (player.frag), -1 for shaders without it
+	GLuint first_matrix;		// First model matrix of the item in the queue's matrices
+	unsigned int instances;		// Copies (per eye), one model matrix each
+};
+
+class RenderQueue {
+public:
+	RenderPass pass;	// Pass the items added next belong to
+
+	RenderQueue();
+
+	/* Queue one draw of a mesh
+	 * shader - shader to draw it with
+	 * mesh - mesh to draw
+	 * model - model matrix
+	 * distance - distance from the eye, for front to back order
+	 * which_player - which_player uniform, -1 if the shader has none
+	 */
+	void add(const Shader & shader, Mesh & mesh, const glm::mat4 & model, float distance, GLint which_player = -1);
+	/* Store model matrices for instanced draws (several meshes of a model can share them)
+	 * matrices - model matrix of each copy
+	 * returns the first matrix, for addInstanced
+	 */
+	GLuint addMatrices(const std::vector<glm::mat4> & matrices);
+	/* Queue an instanced draw of a mesh
+	 * shader - shader to draw it with
+	 * mesh - mesh to draw
+	 * first_matrix - first model matrix of the copies (from addMatrices)
+	 * instances - number of copies (per eye)
+	 */
+	void addInstanced(const Shader & shader, Mesh & mesh, GLuint first_matrix, unsigned int instances);
+
+	// Sort what was queued and draw it, then empty the queue
+	void submit();
+	// Number of queued draws
+	unsigned int size() const;
+
+private:
+	std::vector<RenderItem> items;
+	std::vector<glm::mat4> matrices;		// Model matrices of the items, uploaded to the arena on submit
+	std::vector<DrawCommand> commands;		// One per item, in sorted order
+
+	static uint64_t sortKey(RenderPass pass, const Shader & shader, const Mesh & mesh, float distance);
+};
+
+#endif
@@ -0,0 +1,663 @@
+/* Offscreen render tests
+ * Draws through the game's renderer into a hidden window's context and checks what it did, so they run
+ * on a software driver as well (Mesa llvmpipe: its opengl32.dll next to the exe on Windows, or
+ * LIBGL_ALWAYS_SOFTWARE=1 elsewhere). The hidden window is still a GLFW window, so it needs a display:
+ * on a headless Linux machine run it under a virtual one, e.g. xvfb-run -a ./RenderTests
+ * Run from the Minimal directory, the shaders are loaded by relative path like in the game.
+ *
+ * Usage: RenderTests
+ * Exit status is the number of failed checks
+ */
+#define _CRT_SECURE_NO_DEPRECATE
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "RenderContext.h"
+#include "Model.h"
+#include "Skybox.h"
+#include "Bound.h"
+#include "Curve.h"
+#include "SceneGraph.h"
+#include "Treasure.h"
+
+// Size of the test target
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 240
+// The model the game draws enemies with, used when the assets are checked out next to the shaders
+#define TEST_ENEMY_MODEL "assets/models/obj/cacodemon.obj"
+// Shuffled submission orders tried by the state change test
+#define TEST_QUEUE_ORDERS 20
+// Single-pass vs two-pass stereo: how far a channel may be off, and what fraction of the pixels may be off
+// (edges can land on the other side of a pixel center when the eye is squeezed in the shader instead of the viewport)
+#define TEST_STEREO_TOLERANCE 8
+#define TEST_STEREO_MISMATCH 0.01f
+// Scene walks timed by the traversal test, and enemies in its scene
+#define TEST_TRAVERSAL_PASSES 1000
+#define TEST_TRAVERSAL_ENEMIES 16
+// Half the distance between the test eyes (exaggerated, so the two eyes see visibly different pictures)
+#define TEST_EYE_OFFSET 0.2f
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+static unsigned int failures = 0;
+
+// Print a failed check with its location and count it
+#define CHECK(condition, ...) \
+	do { \
+		if (!(condition)) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+			failures++; \
+		} \
+	} while (0)
+
+/*------------------ HELPER FUNCTIONS -----------------*/
+// Report (and clear) every pending GL error
+void checkGLErrors(const char * where) {
+	for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+		CHECK(false, "GL error 0x%x %s", error, where);
+	}
+}
+
+/* 1x1 texture of a single color, so test meshes can be given distinct materials
+ * returns the texture name
+ */
+GLuint colorTexture(unsigned char r, unsigned char g, unsigned char b) {
+	unsigned char texel[4] = { r, g, b, 255 };
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glState().bindTexture(0, GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return texture;
+}
+
+/* Axis aligned box mesh with outward normals, loaded into the geometry arena
+ * center, size - where the box is and how big (model space)
+ * texture - its one diffuse texture (0 for none)
+ */
+Mesh boxMesh(const vec3 & center, const vec3 & size, GLuint texture) {
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	for (int axis = 0; axis < 3; axis++) {
+		for (int side = -1; side <= 1; side += 2) {
+			vec3 normal(0.0f);
+			normal[axis] = (float)side;
+			// Two directions spanning the face, ordered so the face winds counterclockwise seen from outside
+			vec3 u(0.0f), v(0.0f);
+			u[(axis + 1) % 3] = 1.0f;
+			v[(axis + 2) % 3] = 1.0f;
+			if (side < 0) {
+				std::swap(u, v);
+			}
+			unsigned int first = (unsigned int)vertices.size();
+			for (int corner = 0; corner < 4; corner++) {
+				float a = corner == 1 || corner == 2 ? 1.0f : -1.0f;
+				float b = corner >= 2 ? 1.0f : -1.0f;
+				Vertex vertex;
+				vertex.Position = center + (normal + u * a + v * b) * size * 0.5f;
+				vertex.Normal = normal;
+				vertex.TexCoords = glm::vec2(a * 0.5f + 0.5f, b * 0.5f + 0.5f);
+				vertices.push_back(vertex);
+			}
+			unsigned int face[6] = { 0, 1, 2, 0, 2, 3 };
+			for (unsigned int i = 0; i < 6; i++) {
+				indices.push_back(first + face[i]);
+			}
+		}
+	}
+
+	vector<Texture> textures;
+	if (texture != 0) {
+		Texture diffuse = { texture, "texture_diffuse", "" };
+		textures.push_back(diffuse);
+	}
+	return Mesh(vertices, indices, textures);
+}
+
+/* The enemy model, or a stand-in with several meshes and materials when the assets are not there
+ * returns the model (delete it when done)
+ */
+Model * loadEnemy() {
+	if (std::ifstream(TEST_ENEMY_MODEL).good()) {
+		Model * enemy = new Model(string(TEST_ENEMY_MODEL), false);
+		if (!enemy->meshes.empty()) {
+			return enemy;
+		}
+		delete enemy;
+	}
+	GLuint skin = colorTexture(200, 40, 40);
+	GLuint eye = colorTexture(40, 200, 40);
+	vector<Mesh> meshes;
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(1.0f), skin));
+	meshes.push_back(boxMesh(vec3(0.0f, 0.2f, 0.5f), vec3(0.3f), eye));
+	meshes.push_back(boxMesh(vec3(0.0f, -0.3f, 0.5f), vec3(0.6f, 0.1f, 0.1f), skin));
+	return new Model(meshes);
+}
+
+/* Framebuffer the tests draw into and read back from (the window's own may not exist on a headless driver)
+ * width, height - size in pixels
+ * returns the framebuffer, bound for drawing and reading
+ */
+GLuint createTarget(int width, int height) {
+	GLuint framebuffer, color, depth;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &color);
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	CHECK(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "test framebuffer incomplete");
+	return framebuffer;
+}
+
+/* Point a context at a camera in the origin looking down -z
+ * context - context to fill (its queue is left alone)
+ */
+void lookDownZ(RenderContext & context) {
+	context.projection = glm::perspective(glm::radians(90.0f), (float)TEST_WIDTH / TEST_HEIGHT, 0.1f, 1000.0f);
+	context.view = mat4(1.0f);
+	context.transforms.reset();
+	context.frustum = Frustum(context.projection * context.view);
+	updateFrameUniforms(&context.projection, &context.view, 1);
+}
+
+/* Write a 6x6 checkered PPM for a skybox face (Skybox loads its faces from files)
+ * path - file to write
+ * r, g, b - the face's color, alternating with a darker shade
+ */
+void writeSkyFace(const char * path, unsigned char r, unsigned char g, unsigned char b) {
+	FILE * file = fopen(path, "wb");
+	if (file == NULL) {
+		CHECK(false, "could not write %s", path);
+		return;
+	}
+	fprintf(file, "P6\n6 6\n255\n");
+	for (int i = 0; i < 36; i++) {
+		unsigned char shade = (i / 6 + i % 6) % 2 ? 2 : 1;
+		unsigned char texel[3] = { (unsigned char)(r / shade), (unsigned char)(g / shade), (unsigned char)(b / shade) };
+		fwrite(texel, 1, 3, file);
+	}
+	fclose(file);
+}
+
+/* Pixels whose channels differ by more than TEST_STEREO_TOLERANCE in a range of columns of two
+ * TEST_WIDTH x TEST_HEIGHT RGBA images
+ * first_a, first_b - first column compared in each image
+ * columns - how many columns
+ */
+unsigned int countMismatches(const vector<unsigned char> & a, int first_a, const vector<unsigned char> & b, int first_b, int columns) {
+	unsigned int mismatches = 0;
+	for (int y = 0; y < TEST_HEIGHT; y++) {
+		for (int x = 0; x < columns; x++) {
+			const unsigned char * pixel_a = &a[4 * (y * TEST_WIDTH + first_a + x)];
+			const unsigned char * pixel_b = &b[4 * (y * TEST_WIDTH + first_b + x)];
+			for (int channel = 0; channel < 3; channel++) {
+				if (abs(pixel_a[channel] - pixel_b[channel]) > TEST_STEREO_TOLERANCE) {
+					mismatches++;
+					break;
+				}
+			}
+		}
+	}
+	return mismatches;
+}
+
+// Everything the stereo test draws, one object per stereo shader
+struct StereoScene {
+	const Shader * sky_shader;
+	const Shader * obj_shader;
+	const Shader * player_shader;
+	const Shader * enemy_shader;
+	const Shader * enemy_instanced_shader;
+	const Shader * bound_shader;
+	Skybox * sky;
+	Model * crate;
+	Model * enemy;
+	vector<mat4> enemies;
+	Bound * bound;
+	Curve * path;
+};
+
+/* Draw the stereo test scene in the order RiftApp::renderScene does
+ * context - pass to draw, its matrices, frustum and the Frame block already set for one or both eyes
+ */
+void drawStereoScene(RenderContext & context, StereoScene & scene) {
+	glState().frontFace(GL_CW);
+	context.use(*scene.sky_shader);
+	scene.sky->draw(context);
+	glState().frontFace(GL_CCW);
+
+	// Straddling the middle of the target, half in and half out of each eye's view
+	context.select(*scene.obj_shader);
+	scene.crate->drawAt(context, glm::translate(mat4(1.0f), vec3(1.9f, 0.4f, -3.0f)));
+	scene.crate->drawAt(context, glm::translate(mat4(1.0f), vec3(-1.9f, -0.4f, -3.0f)));
+	context.select(*scene.player_shader);
+	scene.crate->drawAt(context, glm::translate(mat4(1.0f), vec3(-0.6f, 0.9f, -4.0f)), 1);
+	scene.crate->drawAt(context, glm::translate(mat4(1.0f), vec3(0.6f, 0.9f, -4.0f)), 2);
+	context.select(*scene.enemy_instanced_shader);
+	scene.enemy->drawInstanced(context, scene.enemies);
+
+	context.use(*scene.bound_shader);
+	context.transforms.push(glm::translate(mat4(1.0f), vec3(0.0f, -1.2f, -5.0f)));
+	scene.bound->draw(context);
+	context.transforms.pop();
+	// The curve has no normals for enemy_shader to color it with, give it a constant one
+	context.use(*scene.enemy_shader);
+	glVertexAttrib3f(1, 1.0f, 1.0f, 0.0f);
+	scene.path->draw(context);
+
+	context.queue->submit();
+}
+
+/* Render the stereo test scene into the two halves of the target and read it back
+ * single_pass - draw both eyes at once (as RiftApp::draw does with single-pass stereo) or one pass per eye
+ * returns the TEST_WIDTH x TEST_HEIGHT RGBA pixels
+ */
+vector<unsigned char> renderStereo(RenderContext & context, StereoScene & scene, bool single_pass) {
+	const int eye_width = TEST_WIDTH / STEREO_EYES;
+	StereoView & stereo = stereoView();
+	// Off center projections mirrored between the eyes, like a headset's
+	const float near_plane = 0.1f;
+	const float half_height = near_plane * 0.8f;
+	const float outer = half_height * eye_width / TEST_HEIGHT * 1.2f;
+	const float inner = half_height * eye_width / TEST_HEIGHT * 0.8f;
+	stereo.projection[0] = glm::frustum(-outer, inner, -half_height, half_height, near_plane, 500.0f);
+	stereo.projection[1] = glm::frustum(-inner, outer, -half_height, half_height, near_plane, 500.0f);
+	stereo.view[0] = glm::translate(mat4(1.0f), vec3(TEST_EYE_OFFSET, 0.0f, 0.0f));
+	stereo.view[1] = glm::translate(mat4(1.0f), vec3(-TEST_EYE_OFFSET, 0.0f, 0.0f));
+
+	glClearColor(1.0f, 0.0f, 1.0f, 1.0f);
+	glViewport(0, 0, TEST_WIDTH, TEST_HEIGHT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	context.transforms.reset();
+	if (single_pass) {
+		stereo.enabled = true;
+		updateFrameUniforms(stereo.projection, stereo.view, STEREO_EYES);
+		glEnable(GL_CLIP_DISTANCE0);
+		context.projection = stereo.projection[0];
+		context.view = stereo.view[0];
+		context.frustum = Frustum::combined(stereo.projection[0] * stereo.view[0], stereo.projection[1] * stereo.view[1]);
+		drawStereoScene(context, scene);
+		glDisable(GL_CLIP_DISTANCE0);
+		stereo.enabled = false;
+	}
+	else {
+		for (int eye = 0; eye < STEREO_EYES; eye++) {
+			glViewport(eye * eye_width, 0, eye_width, TEST_HEIGHT);
+			updateFrameUniforms(&stereo.projection[eye], &stereo.view[eye], 1);
+			context.projection = stereo.projection[eye];
+			context.view = stereo.view[eye];
+			context.frustum = Frustum(context.projection * context.view);
+			drawStereoScene(context, scene);
+		}
+		glViewport(0, 0, TEST_WIDTH, TEST_HEIGHT);
+	}
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	vector<unsigned char> pixels(4 * TEST_WIDTH * TEST_HEIGHT);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, TEST_WIDTH, TEST_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	return pixels;
+}
+
+/*------------------ TESTS -----------------*/
+/* Instanced enemies cost the same draw calls however many of them there are
+ * (one multi draw per state run, or one draw per mesh without multi draw indirect)
+ */
+void testInstancedDrawCalls(RenderContext & context, const Shader & enemy_shader, Model & enemy) {
+	printf("instanced draw calls\n");
+	const unsigned int copies[] = { 1, 10, 500 };
+	unsigned int calls[3];
+	lookDownZ(context);
+	context.select(enemy_shader);
+
+	for (unsigned int run = 0; run < 3; run++) {
+		// A grid of copies, every one of them in view
+		vector<mat4> transforms;
+		for (unsigned int i = 0; i < copies[run]; i++) {
+			vec3 position(-6.0f + 0.5f * (i % 25), -4.0f + 0.4f * (i / 25 % 20), -10.0f);
+			transforms.push_back(glm::translate(mat4(1.0f), position));
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		meshDrawCalls() = 0;
+		meshesCulled() = 0;
+		enemy.drawInstanced(context, transforms);
+		context.queue->submit();
+		calls[run] = meshDrawCalls();
+
+		CHECK(meshesCulled() == 0, "%u copies: %u meshes culled, expected every copy in view", copies[run], meshesCulled());
+		printf("  %u copies: %u draw calls\n", copies[run], calls[run]);
+	}
+	checkGLErrors("drawing instanced enemies");
+
+	CHECK(calls[0] > 0, "nothing was drawn");
+	CHECK(calls[1] == calls[0], "10 copies took %u draw calls, 1 copy took %u", calls[1], calls[0]);
+	CHECK(calls[2] == calls[0], "500 copies took %u draw calls, 1 copy took %u", calls[2], calls[0]);
+}
+
+/* The render queue's state changes depend on what was queued, not on the order it was queued in
+ * A fixed mix of programs and materials is queued in several shuffled orders. Sorted, the items form one
+ * run per program and, inside it, one run per material, so every submit should switch program once per
+ * program and textures once per program/material pair (all meshes share the arena's vertex array).
+ */
+void testStateChangesIgnoreOrder(RenderContext & context, const Shader & obj_shader, const Shader & player_shader,
+								 const Shader & enemy_shader) {
+	printf("render queue state changes\n");
+	GLuint red = colorTexture(255, 0, 0);
+	GLuint green = colorTexture(0, 255, 0);
+	GLuint blue = colorTexture(0, 0, 255);
+	// Meshes 0/1 share a material, as do 2/4. Mesh 5 has no textures
+	vector<Mesh> meshes;
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(1.0f), red));
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(0.5f), red));
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(1.0f, 0.2f, 0.2f), green));
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(0.2f, 1.0f, 0.2f), blue));
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(0.2f, 0.2f, 1.0f), green));
+	meshes.push_back(boxMesh(vec3(0.0f), vec3(0.7f), 0));
+
+	struct QueuedDraw {
+		const Shader * shader;
+		unsigned int mesh;
+		GLint which_player;		// -1 for shaders without it
+		bool instanced;
+	};
+	const QueuedDraw draws[] = {
+		{ &obj_shader, 0, -1, false }, { &obj_shader, 1, -1, false }, { &obj_shader, 2, -1, false }, { &obj_shader, 5, -1, false },
+		{ &player_shader, 0, 1, false }, { &player_shader, 3, 2, false }, { &player_shader, 1, 2, false }, { &player_shader, 4, 1, false },
+		{ &enemy_shader, 2, -1, true }, { &enemy_shader, 3, -1, true }, { &enemy_shader, 0, -1, true }, { &enemy_shader, 4, -1, true },
+	};
+	const unsigned int num_draws = sizeof(draws) / sizeof(draws[0]);
+
+	std::set<unsigned int> programs;
+	std::set<std::pair<unsigned int, unsigned int>> materials;
+	for (unsigned int i = 0; i < num_draws; i++) {
+		programs.insert(draws[i].shader->ID);
+		materials.insert(std::make_pair(draws[i].shader->ID, meshes[draws[i].mesh].material));
+	}
+	unsigned int expected = (unsigned int)(programs.size() + materials.size());
+
+	lookDownZ(context);
+	vector<mat4> copies;
+	for (unsigned int i = 0; i < 4; i++) {
+		copies.push_back(glm::translate(mat4(1.0f), vec3(-1.5f + i, 1.0f, -5.0f)));
+	}
+	vector<unsigned int> order(num_draws);
+	for (unsigned int i = 0; i < num_draws; i++) {
+		order[i] = i;
+	}
+	std::mt19937 generator(190);
+	std::uniform_real_distribution<float> distances(1.0f, 50.0f);
+
+	for (unsigned int attempt = 0; attempt < TEST_QUEUE_ORDERS; attempt++) {
+		std::shuffle(order.begin(), order.end(), generator);
+		GLuint first_copy = context.queue->addMatrices(copies);
+		for (unsigned int i = 0; i < num_draws; i++) {
+			const QueuedDraw & draw = draws[order[i]];
+			Mesh & mesh = meshes[draw.mesh];
+			if (draw.instanced) {
+				context.queue->addInstanced(*draw.shader, mesh, first_copy, (unsigned int)copies.size());
+			}
+			else {
+				mat4 model = glm::translate(mat4(1.0f), vec3(-2.0f + 0.5f * order[i], -1.0f, -5.0f));
+				context.queue->add(*draw.shader, mesh, model, distances(generator), draw.which_player);
+			}
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderStateChanges() = 0;
+		context.queue->submit();
+		CHECK(renderStateChanges() == expected, "order %u: %u state changes, expected %u (%u programs, %u program/material runs)",
+			attempt, renderStateChanges(), expected, (unsigned int)programs.size(), (unsigned int)materials.size());
+	}
+	checkGLErrors("submitting shuffled queues");
+	printf("  %u orders, %u state changes expected each\n", TEST_QUEUE_ORDERS, expected);
+}
+
+/* Single-pass stereo draws the same picture as a pass per eye
+ * Renders a scene going through every stereo vertex shader (skybox, obj, player, enemy, instanced enemy and
+ * bounds) both ways and compares the read back images. Objects stick out of each eye's view across the middle
+ * of the target, where the single-pass shaders clip them (gl_ClipDistance), and the eyes get different off
+ * center projections, so drawing an instance into the wrong eye (gl_InstanceID % 2) shows as well.
+ */
+void testSinglePassMatchesTwoPass(RenderContext & context, const Shader & obj_shader, const Shader & player_shader,
+								  const Shader & enemy_instanced_shader, Model & enemy) {
+	printf("single-pass stereo\n");
+	Shader sky_shader("skybox.vert", "skybox.frag");
+	Shader enemy_shader("enemy_shader.vert", "enemy_shader.frag");
+	Shader bound_shader("Bounds.vert", "Bounds.frag");
+
+	// Skybox faces in Skybox's order (pz, px, nx, py, ny, nz), removed again once loaded
+	char face_paths[6][32];
+	vector<char *> faces;
+	const unsigned char face_colors[6][3] = { { 200, 60, 60 }, { 60, 200, 60 }, { 60, 60, 200 }, { 200, 200, 60 }, { 60, 200, 200 }, { 200, 60, 200 } };
+	for (int i = 0; i < 6; i++) {
+		sprintf(face_paths[i], "RenderTests_sky%d.ppm", i);
+		writeSkyFace(face_paths[i], face_colors[i][0], face_colors[i][1], face_colors[i][2]);
+		faces.push_back(face_paths[i]);
+	}
+	Skybox sky(faces);
+	for (int i = 0; i < 6; i++) {
+		remove(face_paths[i]);
+	}
+	// Skybox sets the fixed function texture environment, which a core context rejects
+	while (glGetError() != GL_NO_ERROR) {}
+
+	vector<Mesh> crate_meshes;
+	crate_meshes.push_back(boxMesh(vec3(0.0f), vec3(1.0f), colorTexture(230, 160, 40)));
+	crate_meshes.push_back(boxMesh(vec3(0.0f, 0.6f, 0.0f), vec3(0.4f), colorTexture(40, 160, 230)));
+	Model crate(crate_meshes);
+	Bound bound(0.3f, 0.1f, 0.1f);
+	Curve path(mat4(vec4(-3.0f, -1.0f, -4.0f, 1.0f), vec4(-1.0f, 2.0f, -4.0f, 1.0f),
+		vec4(1.0f, -2.0f, -4.0f, 1.0f), vec4(3.0f, 1.0f, -4.0f, 1.0f)));
+
+	StereoScene scene;
+	scene.sky_shader = &sky_shader;
+	scene.obj_shader = &obj_shader;
+	scene.player_shader = &player_shader;
+	scene.enemy_shader = &enemy_shader;
+	scene.enemy_instanced_shader = &enemy_instanced_shader;
+	scene.bound_shader = &bound_shader;
+	scene.sky = &sky;
+	scene.crate = &crate;
+	scene.enemy = &enemy;
+	scene.bound = &bound;
+	scene.path = &path;
+	for (int i = 0; i < 7; i++) {
+		scene.enemies.push_back(glm::translate(mat4(1.0f), vec3(-3.0f + i, -0.2f + 0.1f * i, -6.0f)));
+	}
+	checkGLErrors("loading the stereo scene");
+
+	vector<unsigned char> two_pass = renderStereo(context, scene, false);
+	checkGLErrors("drawing one pass per eye");
+	vector<unsigned char> single_pass = renderStereo(context, scene, true);
+	checkGLErrors("drawing single-pass stereo");
+
+	const int eye_width = TEST_WIDTH / STEREO_EYES;
+	const unsigned int eye_pixels = eye_width * TEST_HEIGHT;
+	const unsigned int allowed = (unsigned int)(eye_pixels * TEST_STEREO_MISMATCH);
+	vector<unsigned char> cleared(4 * TEST_WIDTH * TEST_HEIGHT);
+	for (size_t i = 0; i < cleared.size(); i += 4) {
+		cleared[i] = 255;
+		cleared[i + 2] = 255;
+		cleared[i + 3] = 255;
+	}
+	for (int eye = 0; eye < STEREO_EYES; eye++) {
+		unsigned int mismatches = countMismatches(single_pass, eye * eye_width, two_pass, eye * eye_width, eye_width);
+		printf("  eye %d: %u of %u pixels differ\n", eye, mismatches, eye_pixels);
+		CHECK(mismatches <= allowed, "eye %d: %u pixels differ between single-pass and two-pass, at most %u allowed", eye, mismatches, allowed);
+		// Both images must actually have drawn something in this eye (the skybox covers all of it)
+		unsigned int drawn = countMismatches(two_pass, eye * eye_width, cleared, eye * eye_width, eye_width);
+		CHECK(drawn == eye_pixels, "eye %d: %u of %u pixels left at the clear color", eye, eye_pixels - drawn, eye_pixels);
+	}
+	unsigned int eyes_differ = countMismatches(two_pass, 0, two_pass, eye_width, eye_width);
+	CHECK(eyes_differ > allowed, "the two eyes look the same (%u pixels differ), the test would not catch swapped eyes", eyes_differ);
+	glVertexAttrib3f(1, 0.0f, 0.0f, 0.0f);
+}
+
+/* Cost of walking the game's scene through the render context (RiftApp::renderScene without the skybox)
+ * The treasure, both players' head, hand and sword and a group of instanced enemies are placed through a
+ * SceneGraph and queued by the real Model/Treasure draw calls. Only the walk that fills the queue is timed,
+ * submitting it is not.
+ */
+void testSceneTraversal(RenderContext & context, const Shader & obj_shader, const Shader & player_shader,
+						const Shader & enemy_shader, Model & enemy) {
+	printf("scene traversal\n");
+	GLuint stone = colorTexture(120, 120, 120);
+	GLuint gold = colorTexture(230, 190, 40);
+	GLuint skin = colorTexture(230, 180, 150);
+	GLuint steel = colorTexture(180, 180, 200);
+	vector<Mesh> pedestal_meshes(1, boxMesh(vec3(0.0f), vec3(0.5f, 1.0f, 0.5f), stone));
+	vector<Mesh> treasure_meshes(1, boxMesh(vec3(0.0f), vec3(0.4f, 0.3f, 0.3f), gold));
+	vector<Mesh> head_meshes(1, boxMesh(vec3(0.0f), vec3(0.3f), skin));
+	head_meshes.push_back(boxMesh(vec3(0.0f, 0.0f, -0.2f), vec3(0.2f, 0.05f, 0.05f), steel));
+	vector<Mesh> hand_meshes(1, boxMesh(vec3(0.0f), vec3(0.1f), skin));
+	vector<Mesh> sword_meshes(1, boxMesh(vec3(0.0f), vec3(0.05f, 1.0f, 0.05f), steel));
+	sword_meshes.push_back(boxMesh(vec3(0.0f, -0.4f, 0.0f), vec3(0.3f, 0.05f, 0.05f), steel));
+	Model pedestal(pedestal_meshes);
+	Model treasure_model(treasure_meshes);
+	Model head(head_meshes);
+	Model hand(hand_meshes);
+	Model sword(sword_meshes);
+	Model * player_models[3] = { &head, &hand, &sword };
+
+	// Same scene layout as the game: the treasure first, then each player's hand and head with their models under them
+	SceneGraph scene;
+	Treasure treasure(&pedestal, &treasure_model);
+	treasure.addToScene(scene);
+	unsigned int model_nodes[2][3];
+	for (unsigned int p = 0; p < 2; p++) {
+		vec3 offset(p == 0 ? -0.8f : 0.8f, 0.0f, 2.0f);
+		unsigned int hand_node = scene.add(glm::translate(mat4(1.0f), offset + vec3(0.3f, -0.3f, -0.4f)));
+		unsigned int head_node = scene.add(glm::translate(mat4(1.0f), offset));
+		model_nodes[p][0] = scene.add(head.getToWorld(), head_node);
+		model_nodes[p][1] = scene.add(hand.getToWorld(), hand_node);
+		model_nodes[p][2] = scene.add(sword.getToWorld(), hand_node);
+	}
+	scene.update();
+	vector<mat4> enemies;
+	for (unsigned int i = 0; i < TEST_TRAVERSAL_ENEMIES; i++) {
+		enemies.push_back(glm::translate(mat4(1.0f), vec3(-3.0f + 0.4f * i, 0.5f * (i % 3), -3.0f)));
+	}
+	// Every mesh is in view, so each pass queues all of them (the enemy's once for all its copies)
+	unsigned int expected = (unsigned int)(pedestal.meshes.size() + treasure_model.meshes.size() +
+		2 * (head.meshes.size() + hand.meshes.size() + sword.meshes.size()) + enemy.meshes.size());
+
+	mat4 projection = glm::perspective(glm::radians(90.0f), (float)TEST_WIDTH / TEST_HEIGHT, 0.1f, 1000.0f);
+	mat4 view = glm::lookAt(vec3(0.0f, 1.0f, 5.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+	updateFrameUniforms(&projection, &view, 1);
+	double walk_seconds = 0.0;
+	unsigned int queued = 0;
+
+	for (unsigned int pass = 0; pass < TEST_TRAVERSAL_PASSES; pass++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		context.projection = projection;
+		context.view = view;
+		context.transforms.reset();
+		context.frustum = Frustum(context.projection * context.view);
+		context.select(obj_shader);
+		treasure.draw(context, scene);
+		context.select(player_shader);
+		for (unsigned int p = 0; p < 2; p++) {
+			// As Player::drawPlayer does
+			for (unsigned int i = 0; i < 3; i++) {
+				player_models[i]->drawAt(context, scene.world(model_nodes[p][i]), p + 1);
+			}
+		}
+		context.select(enemy_shader);
+		enemy.drawInstanced(context, enemies);
+		walk_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		queued = context.queue->size();
+		CHECK(pass > 0 || queued == expected, "%u draws queued, expected %u (every mesh in view)", queued, expected);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		context.queue->submit();
+	}
+	checkGLErrors("drawing the traversal scene");
+	double pass_ns = walk_seconds * 1000000000.0 / TEST_TRAVERSAL_PASSES;
+	printf("  %u draws queued per pass: %.0f ns per pass, %.0f ns per draw\n", queued, pass_ns, pass_ns / queued);
+}
+
+int main() {
+	if (!glfwInit()) {
+		printf("Failed to initialize GLFW (no display? run under Xvfb on a headless machine)\n");
+		return 1;
+	}
+	// Same context as the game, in a window that never shows
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	glfwWindowHint(GLFW_DEPTH_BITS, 16);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	GLFWwindow * window = glfwCreateWindow(TEST_WIDTH, TEST_HEIGHT, "RenderTests", NULL, NULL);
+	if (!window) {
+		printf("Failed to create a GL 4.1 core context in a hidden window (needs a display, e.g. Xvfb, and a GL 4.1 driver)\n");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glewExperimental = GL_TRUE;
+	if (0 != glewInit()) {
+		printf("Failed to initialize GLEW\n");
+		glfwTerminate();
+		return 1;
+	}
+	glGetError();
+	printf("%s, GL %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+
+	createTarget(TEST_WIDTH, TEST_HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, TEST_WIDTH, TEST_HEIGHT);
+
+	{
+		Shader obj_shader("obj_shader.vert", "obj_shader.frag");
+		Shader player_shader("player.vert", "player.frag");
+		Shader enemy_instanced_shader("enemy_instanced.vert", "enemy_shader.frag");
+		RenderQueue queue;
+		RenderContext context;
+		context.queue = &queue;
+		Model * enemy = loadEnemy();
+		checkGLErrors("loading");
+
+		testInstancedDrawCalls(context, enemy_instanced_shader, *enemy);
+		testStateChangesIgnoreOrder(context, obj_shader, player_shader, enemy_instanced_shader);
+		testSinglePassMatchesTwoPass(context, obj_shader, player_shader, enemy_instanced_shader, *enemy);
+		testSceneTraversal(context, obj_shader, player_shader, enemy_instanced_shader, *enemy);
+
+		delete enemy;
+	}
+
+	printf(failures ? "%u checks FAILED\n" : "all tests passed\n", failures);
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return (int)failures;
+}
@@ -0,0 +1,70 @@
+#include "SceneGraph.h"
+#include <stdio.h>
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+SceneGraph::SceneGraph() {
+	first_dirty = 0;
+	last_updated = 0;
+}
+
+/*----------------- MORE GAME-RELATED FUNCTIONS -----------------*/
+unsigned int SceneGraph::add(const glm::mat4 & local, unsigned int parent) {
+	unsigned int node = (unsigned int)locals.size();
+	if (parent != SCENE_ROOT && parent >= node) {
+		printf("SceneGraph: parent %u of node %u does not exist yet, adding it at the root\n", parent, node);
+		parent = SCENE_ROOT;
+	}
+
+	locals.push_back(local);
+	worlds.push_back(local);
+	parents.push_back(parent);
+	dirty.push_back(1);
+	if (node < first_dirty) {
+		first_dirty = node;
+	}
+	return node;
+}
+
+void SceneGraph::setLocal(unsigned int node, const glm::mat4 & local) {
+	if (locals[node] == local) {
+		return;
+	}
+	locals[node] = local;
+	dirty[node] = 1;
+	if (node < first_dirty) {
+		first_dirty = node;
+	}
+}
+
+void SceneGraph::update() {
+	last_updated = 0;
+	unsigned int count = (unsigned int)locals.size();
+	for (unsigned int node = first_dirty; node < count; node++) {
+		unsigned int parent = parents[node];
+		// Parents come first, so a moved parent has already been flagged and recomputed
+		if (parent != SCENE_ROOT && dirty[parent]) {
+			dirty[node] = 1;
+		}
+		if (dirty[node]) {
+			worlds[node] = parent == SCENE_ROOT ? locals[node] : worlds[parent] * locals[node];
+			last_updated++;
+		}
+	}
+	// Clear afterwards, children read their parent's flag during the pass
+	for (unsigned int node = first_dirty; node < count; node++) {
+		dirty[node] = 0;
+	}
+	first_dirty = count;
+}
+
+const glm::mat4 & SceneGraph::world(unsigned int node) const {
+	return worlds[node];
+}
+
+unsigned int SceneGraph::size() const {
+	return (unsigned int)locals.size();
+}
+
+unsigned int SceneGraph::updatedLastTime() const {
+	return last_updated;
+}
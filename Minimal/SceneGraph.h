@@ -0,0 +1,54 @@
+/* Flattened transform hierarchy for the scene
+ * Nodes live in arrays in topological order: a node's parent always has a smaller index, so a single
+ * front-to-back pass sees every parent before its children. World matrices are cached and only
+ * recomputed for nodes whose local transform changed, and their descendants. Static parts of the scene
+ * (the pedestal, the treasure) are computed once and then only read.
+ */
+#pragma once
+#ifndef _SCENE_GRAPH_H_
+#define _SCENE_GRAPH_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+// Parent of top level nodes
+#define SCENE_ROOT 0xFFFFFFFFu
+
+class SceneGraph {
+public:
+	SceneGraph();
+
+	/* Add a node under an existing one. Returns its index
+	 * local - transform relative to the parent (world = parent's world * local)
+	 * parent - index of an existing node, or SCENE_ROOT
+	 */
+	unsigned int add(const glm::mat4 & local, unsigned int parent = SCENE_ROOT);
+	/* Change a node's local transform. Only marks it dirty when the matrix actually changed
+	 * node - node index
+	 * local - transform relative to the parent
+	 */
+	void setLocal(unsigned int node, const glm::mat4 & local);
+	// Recompute the world matrices of dirty nodes and everything under them
+	void update();
+
+	// Cached world matrix of a node (as of the last update)
+	const glm::mat4 & world(unsigned int node) const;
+	// Nodes in the graph
+	unsigned int size() const;
+	// World matrices recomputed by the last update
+	unsigned int updatedLastTime() const;
+
+private:
+	std::vector<glm::mat4> locals;
+	std::vector<glm::mat4> worlds;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned char> dirty;
+	unsigned int first_dirty;		// Nodes before it are all clean, so update starts here
+	unsigned int last_updated;
+};
+
+#endif
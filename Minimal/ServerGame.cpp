@@ -1,5 +1,6 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "ServerGame.h"
+#include <algorithm>
 
 unsigned int ServerGame::client_id; 
 
@@ -7,6 +8,19 @@ ServerGame::ServerGame(void)
 {
     // id's to assign clients for our table
     client_id = 0;
+	players_required = 1;
+	snapshot_sequence = SNAPSHOT_NO_ACK;
+
+    // set up the server network to listen 
+    network = new ServerNetwork(); 
+}
+
+ServerGame::ServerGame(unsigned int players_required)
+{
+    // id's to assign clients for our table
+    client_id = 0;
+	this->players_required = players_required;
+	snapshot_sequence = SNAPSHOT_NO_ACK;
 
     // set up the server network to listen 
     network = new ServerNetwork(); 
@@ -18,40 +32,63 @@ ServerGame::~ServerGame(void)
 
 void ServerGame::update()
 {
-    // get new clients
-   if(network->acceptNewClient(client_id))
-   {
-        printf("client %d has been connected to the server\n",client_id);
+    update(0);
+}
 
-        client_id++;
-   }
+void ServerGame::update(int timeout_ms)
+{
+    // accept new clients and read from every ready client in one readiness pass
+    unsigned int first_new = client_id;
+    network->poll(client_id, timeout_ms);
+
+    for (unsigned int id = first_new; id < client_id; id++)
+    {
+        printf("client %d has been connected to the server\n", id);
+    }
 
    receiveFromClients();
 }
 
+void ServerGame::flushPackets()
+{
+    network->flush();
+}
+
+unsigned long long ServerGame::bytesSent()
+{
+    return network->bytes_sent;
+}
+
 void ServerGame::receiveFromClients()
 {
 
     Packet packet;
 
     // go through all clients
-    std::map<unsigned int, SOCKET>::iterator iter;
+    std::map<unsigned int, ClientSession>::iterator iter;
 
     for(iter = network->sessions.begin(); iter != network->sessions.end(); iter++)
     {
-        int data_length = network->receiveData(iter->first, network_data);
+        char * frame;
+        unsigned int frame_length;
 
-        if (data_length <= 0) 
-        {
-            //no data received
-            continue;
-        }
+        // handle every complete frame (TCP first, then UDP), a partial one stays buffered until the rest arrives
+        FrameBuffer * channels[2] = { &iter->second.recv_frames, &iter->second.datagram_frames };
+        unsigned int channel = 0;
 
-        int i = 0;
-        while (i < (unsigned int)data_length) 
+        while (channel < 2) 
         {
-            packet.deserialize(&(network_data[i]));
-            i += sizeof(Packet);
+            if (!channels[channel]->nextFrame(frame, frame_length))
+            {
+                channel++;
+                continue;
+            }
+
+            if (!packet.deserialize(frame, frame_length))
+            {
+                printf("error in packet size\n");
+                continue;
+            }
 
             switch (packet.packet_type) {
 
@@ -59,11 +96,16 @@ void ServerGame::receiveFromClients()
 
                     printf("server received init packet from client. Successful connection!\n");
 
-					// Found 2nd player!
-					player2Found = true;
+					// A repeated INIT must not give the same client a second slot
+					if (std::find(players.begin(), players.end(), iter->first) == players.end()) {
+						players.push_back(iter->first);
+					}
 
-					// Notify player 2 of connection
-                    sendActionPackets();
+					// Found every player! Notify them of the connection
+					if (!player2Found && players.size() >= players_required) {
+						player2Found = true;
+						sendActionPackets();
+					}
 
                     break;
 
@@ -80,6 +122,11 @@ void ServerGame::receiveFromClients()
 					// Populate transform matrices
 					receivedHandTransform = packet.hand_transform;
 					receivedHeadTransform = packet.head_transform;
+					clientHandTransforms[iter->first] = packet.hand_transform;
+					clientHeadTransforms[iter->first] = packet.head_transform;
+					clientAcks[iter->first] = (unsigned short)packet.ack;
+					clientPoseTimes[iter->first] = packet.time;
+					clientPoseBuffers[iter->first].push(packet.time, PoseBuffer::localTime(), packet.hand_transform, packet.head_transform);
 					break;
 
 				case TRANSFORMS_AND_INDICES:
@@ -93,39 +140,91 @@ void ServerGame::receiveFromClients()
                     break;
             }
         }
+
+        // ServerNetwork erases a closed session on the next poll, forget the client with it
+        if (iter->second.closed)
+        {
+            dropClient(iter->first);
+        }
     }
 }
 
+void ServerGame::dropClient(unsigned int client)
+{
+	printf("client %d has disconnected\n", client);
+
+	for (std::vector<unsigned int>::iterator iter = players.begin(); iter != players.end(); iter++) {
+		if (*iter == client) {
+			players.erase(iter);
+			break;
+		}
+	}
+	clientAcks.erase(client);
+	clientHandTransforms.erase(client);
+	clientHeadTransforms.erase(client);
+	clientPoseTimes.erase(client);
+	clientPoseBuffers.erase(client);
+
+	// Callers index players up to players_required, wait for a replacement before resuming
+	if (players.size() < players_required) {
+		player2Found = false;
+	}
+}
+
 
 void ServerGame::sendActionPackets()
 {
     // send action packet
-    const unsigned int packet_size = sizeof(Packet);
-    char packet_data[packet_size];
+    char packet_data[MAX_FRAMED_PACKET_SIZE];
 
     Packet packet;
     packet.packet_type = ACTION_EVENT;
 
-    packet.serialize(packet_data);
+    unsigned int packet_size = packet.serializeFrame(packet_data);
 
     network->sendToAll(packet_data,packet_size);
 }
 
-void ServerGame::sendPackets(glm::mat4 hand_transform, glm::mat4 head_transform, std::vector<unsigned int> path_inds) {
-	// Get packet size
-	const unsigned int packet_size = sizeof(Packet);
-	char packet_data[packet_size];
-	
-	// Send head and hand packets to clients
-	Packet packet;
-	packet.packet_type = TRANSFORMS_AND_INDICES;
-	packet.hand_transform = hand_transform;
-	packet.head_transform = head_transform;
-	for (unsigned int i = 0; i < 4; i++) {
-		packet.indices[i] = path_inds[i];
+bool ServerGame::sampleClientPose(unsigned int client, double local_time, glm::mat4 & hand_transform, glm::mat4 & head_transform) {
+	std::map<unsigned int, PoseBuffer>::iterator iter = clientPoseBuffers.find(client);
+	if (iter == clientPoseBuffers.end()) {
+		return false;
 	}
+	return iter->second.sample(local_time, hand_transform, head_transform);
+}
 
-	packet.serialize(packet_data);
-
-	network->sendToAll(packet_data, packet_size);
-}
\ No newline at end of file
+void ServerGame::sendSnapshots(WorldSnapshot & snapshot, unsigned int first_player_slot) {
+	// Sequence 0 is reserved for "nothing acked"
+	if (++snapshot_sequence == SNAPSHOT_NO_ACK) {
+		snapshot_sequence++;
+	}
+	snapshot.sequence = snapshot_sequence;
+	snapshot_history.store(snapshot);
+
+	std::vector<char> frame;
+	for (unsigned int i = 0; i < players.size(); i++) {
+		unsigned int client = players[i];
+
+		// Delta against the client's last ack, as long as both ends still have it
+		const WorldSnapshot * baseline = NULL;
+		std::map<unsigned int, unsigned short>::iterator ack = clientAcks.find(client);
+		if (ack != clientAcks.end() && ack->second != SNAPSHOT_NO_ACK &&
+			(unsigned short)(snapshot_sequence - ack->second) < SNAPSHOT_HISTORY) {
+			baseline = snapshot_history.find(ack->second);
+		}
+
+		frame.assign(FRAME_HEADER_SIZE, 0);
+		frame.push_back((char)WORLD_SNAPSHOT);
+		// The client's own pose is never sent back to it
+		snapshot.writeDelta(baseline, (int)(first_player_slot + i), frame);
+
+		if (frame.size() - FRAME_HEADER_SIZE > MAX_FRAME_PAYLOAD) {
+			printf("snapshot too large to send: %d bytes\n", (int)frame.size());
+			continue;
+		}
+		writeFrameHeader(&frame[0], (unsigned int)(frame.size() - FRAME_HEADER_SIZE));
+
+		// Snapshots only matter until the next one, so they go on the unreliable channel
+		network->sendUnreliable(client, &frame[0], (int)frame.size());
+	}
+}
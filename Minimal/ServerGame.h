@@ -1,6 +1,8 @@
 #pragma once
 #include "ServerNetwork.h"
 #include "NetworkData.h"
+#include "Snapshot.h"
+#include "PoseBuffer.h"
 
 class ServerGame
 {
@@ -10,33 +12,74 @@ public:
 	glm::mat4 receivedHandTransform;
 	glm::mat4 receivedHeadTransform;
 
-	// Data to check if 2nd player has been found
+	/* Latest transforms from each client, keyed by client id */
+	std::map<unsigned int, glm::mat4> clientHandTransforms;
+	std::map<unsigned int, glm::mat4> clientHeadTransforms;
+	std::map<unsigned int, unsigned int> clientPoseTimes;		// Client's clock for those transforms
+	// Every pose received from each client, for smooth playback
+	std::map<unsigned int, PoseBuffer> clientPoseBuffers;
+
+	// Client ids in the order they joined (a dedicated server's players 1 and 2)
+	std::vector<unsigned int> players;
+
+	// Data to check if 2nd player has been found (every required client has joined)
 	bool player2Found = false;
 
     ServerGame(void);
+	/* ServerGame constructor
+	 * players_required - clients needed before the match starts (1 for the Rift host, 2 for a dedicated server)
+	 */
+	ServerGame(unsigned int players_required);
     ~ServerGame(void);
 
+    // Accept and read from clients without blocking
     void update();
+	/* Accept and read from clients
+	 * timeout_ms - how long to wait for network activity before returning
+	 */
+	void update(int timeout_ms);
+
+	// Write out every packet queued since the last flush (call once per tick)
+	void flushPackets();
+
+	// Bytes sent to all clients since startup
+	unsigned long long bytesSent();
 
 	void receiveFromClients();
 
 	void sendActionPackets();
 
-	/* Send player 2 and enemies' location data to clients
-	 * hand_transform - hand transformation matrix
-	 * head_transform - head transformation matrix
-	 * path_inds - contains all 4 path indices of each enemy
+	/* Pose of a client smoothed by its jitter buffer
+	 * local_time - render time (PoseBuffer::localTime)
+	 * returns false if nothing has been received from the client yet
 	 */
-	void sendPackets(glm::mat4 hand_transform, glm::mat4 head_transform, std::vector<unsigned int> path_inds);
+	bool sampleClientPose(unsigned int client, double local_time, glm::mat4 & hand_transform, glm::mat4 & head_transform);
+
+	/* Send the world state to every player, each as a delta against the last snapshot that player acked
+	 * snapshot - current state, its sequence number is assigned here
+	 * first_player_slot - snapshot slot of players[0] (1 when the host plays as player 1, 0 on a dedicated server)
+	 */
+	void sendSnapshots(WorldSnapshot & snapshot, unsigned int first_player_slot);
 
 private:
 
+	// Number of clients needed before player2Found is set
+	unsigned int players_required;
+
    // IDs for the clients connecting for table in ServerNetwork 
     static unsigned int client_id;
 
    // The ServerNetwork object 
     ServerNetwork* network;
 
-	// data buffer
-   char network_data[MAX_PACKET_SIZE];
+	// Recent snapshots (delta baselines) and the last one each client acked
+	SnapshotHistory snapshot_history;
+	unsigned short snapshot_sequence;
+	std::map<unsigned int, unsigned short> clientAcks;
+
+	/* Forget everything kept for a client whose session closed
+	 * client - id of the closed session
+	 */
+	void dropClient(unsigned int client);
+
 };
\ No newline at end of file
@@ -1,31 +1,27 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "ServerNetwork.h"
+#include <string.h>
 
 
 ServerNetwork::ServerNetwork(void)
 {
-	// create WSADATA object
-    WSADATA wsaData;
-
-    // our sockets for the server
+    // our socket for the server
     ListenSocket = INVALID_SOCKET;
-    ClientSocket = INVALID_SOCKET;
-
-
+    bytes_sent = 0;
 
     // address info for the server to listen to
     struct addrinfo *result = NULL;
     struct addrinfo hints;
 
-    // Initialize Winsock
-    iResult = WSAStartup(MAKEWORD(2,2), &wsaData);
+    // Initialize the socket library
+    iResult = NetworkServices::initialize();
     if (iResult != 0) {
-        printf("WSAStartup failed with error: %d\n", iResult);
+        printf("socket startup failed with error: %d\n", iResult);
         exit(1);
     }
 
     // set address information
-    ZeroMemory(&hints, sizeof(hints));
+    memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_INET;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;    // TCP connection!!!
@@ -36,7 +32,7 @@ ServerNetwork::ServerNetwork(void)
 
     if ( iResult != 0 ) {
         printf("getaddrinfo failed with error: %d\n", iResult);
-        WSACleanup();
+        NetworkServices::cleanup();
         exit(1);
     }
 
@@ -44,31 +40,36 @@ ServerNetwork::ServerNetwork(void)
     ListenSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
 
     if (ListenSocket == INVALID_SOCKET) {
-        printf("socket failed with error: %ld\n", WSAGetLastError());
+        printf("socket failed with error: %d\n", NetworkServices::getLastError());
         freeaddrinfo(result);
-        WSACleanup();
+        NetworkServices::cleanup();
         exit(1);
     }
 
     // Set the mode of the socket to be nonblocking
-    u_long iMode = 1;
-    iResult = ioctlsocket(ListenSocket, FIONBIO, &iMode);
+    iResult = NetworkServices::setNonBlocking(ListenSocket);
 
     if (iResult == SOCKET_ERROR) {
-        printf("ioctlsocket failed with error: %d\n", WSAGetLastError());
-        closesocket(ListenSocket);
-        WSACleanup();
+        printf("setting nonblocking mode failed with error: %d\n", NetworkServices::getLastError());
+        NetworkServices::closeSocket(ListenSocket);
+        NetworkServices::cleanup();
         exit(1);
     }
 
+#ifndef _WIN32
+    // let a restarted server rebind while old connections sit in TIME_WAIT
+    int reuse = 1;
+    setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
     // Setup the TCP listening socket
     iResult = bind( ListenSocket, result->ai_addr, (int)result->ai_addrlen);
 
     if (iResult == SOCKET_ERROR) {
-        printf("bind failed with error: %d\n", WSAGetLastError());
+        printf("bind failed with error: %d\n", NetworkServices::getLastError());
         freeaddrinfo(result);
-        closesocket(ListenSocket);
-        WSACleanup();
+        NetworkServices::closeSocket(ListenSocket);
+        NetworkServices::cleanup();
         exit(1);
     }
 
@@ -79,75 +80,408 @@ ServerNetwork::ServerNetwork(void)
     iResult = listen(ListenSocket, SOMAXCONN);
 
     if (iResult == SOCKET_ERROR) {
-        printf("listen failed with error: %d\n", WSAGetLastError());
-        closesocket(ListenSocket);
-        WSACleanup();
+        printf("listen failed with error: %d\n", NetworkServices::getLastError());
+        NetworkServices::closeSocket(ListenSocket);
+        NetworkServices::cleanup();
         exit(1);
     }
+
+    // UDP socket on the same port for the unreliable channel
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_PASSIVE;
+
+    UdpSocket = INVALID_SOCKET;
+    if (getaddrinfo(NULL, DEFAULT_PORT, &hints, &result) == 0) {
+        UdpSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+
+        if (UdpSocket != INVALID_SOCKET &&
+            (NetworkServices::setNonBlocking(UdpSocket) == SOCKET_ERROR ||
+             bind(UdpSocket, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR)) {
+            NetworkServices::closeSocket(UdpSocket);
+            UdpSocket = INVALID_SOCKET;
+        }
+        freeaddrinfo(result);
+    }
+    // Not fatal, clients just stay on TCP
+    if (UdpSocket == INVALID_SOCKET) {
+        printf("UDP socket unavailable (error %d), using TCP only\n", NetworkServices::getLastError());
+    }
+
+    std::random_device seed;
+    token_generator.seed(seed());
+
+    // accepts and reads are both driven by the poller
+    poller = NetworkPoller::create();
+    poller->add(ListenSocket, false);
+    if (UdpSocket != INVALID_SOCKET) {
+        poller->add(UdpSocket, false);
+    }
 }
 
 
 ServerNetwork::~ServerNetwork(void)
 {
+    std::map<unsigned int, ClientSession>::iterator iter;
+    for (iter = sessions.begin(); iter != sessions.end(); iter++)
+    {
+        if (!iter->second.closed)
+        {
+            NetworkServices::closeSocket(iter->second.socket);
+        }
+    }
+    NetworkServices::closeSocket(ListenSocket);
+    if (UdpSocket != INVALID_SOCKET)
+    {
+        NetworkServices::closeSocket(UdpSocket);
+    }
+    delete poller;
+    NetworkServices::cleanup();
+}
+
+unsigned int ServerNetwork::poll(unsigned int & id, int timeout_ms)
+{
+    // drop sessions that closed during the last poll (ServerGame has consumed their data by now)
+    std::map<unsigned int, ClientSession>::iterator iter = sessions.begin();
+    while (iter != sessions.end())
+    {
+        if (iter->second.closed)
+        {
+            token_ids.erase(iter->second.udp_token);
+            iter = sessions.erase(iter);
+        }
+        else
+        {
+            iter++;
+        }
+    }
+
+    // edge-triggered sockets are not reported again for data we left behind, so pick it up now
+    bool read_pending = false;
+    for (iter = sessions.begin(); iter != sessions.end(); iter++)
+    {
+        if (iter->second.read_pending)
+        {
+            readFromClient(iter->second);
+            read_pending = true;
+        }
+    }
+
+    PollEvent events[MAX_EVENTS_PER_POLL];
+    int count = poller->wait(events, MAX_EVENTS_PER_POLL, read_pending ? 0 : timeout_ms);
+
+    if (count < 0)
+    {
+        printf("poll failed with error: %d\n", NetworkServices::getLastError());
+        return 0;
+    }
+
+    unsigned int accepted = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].socket == ListenSocket)
+        {
+            accepted += acceptNewClients(id);
+            continue;
+        }
+        if (events[i].socket == UdpSocket)
+        {
+            readDatagrams();
+            continue;
+        }
+
+        std::map<SOCKET, unsigned int>::iterator id_iter = socket_ids.find(events[i].socket);
+        if (id_iter == socket_ids.end())
+        {
+            continue;
+        }
+        ClientSession & session = sessions[id_iter->second];
+
+        if (events[i].events & (POLL_READ | POLL_ERROR))
+        {
+            readFromClient(session);
+        }
+        if (!session.closed && (events[i].events & POLL_WRITE))
+        {
+            writeToClient(session);
+        }
+    }
+
+    return accepted;
 }
 
 // accept new connections
-bool ServerNetwork::acceptNewClient(unsigned int & id)
+unsigned int ServerNetwork::acceptNewClients(unsigned int & id)
 {
-    // if client waiting, accept the connection and save the socket
-    ClientSocket = accept(ListenSocket,NULL,NULL);
+    unsigned int accepted = 0;
 
-    if (ClientSocket != INVALID_SOCKET) 
+    // the listen socket is edge-triggered too, so accept until there is no one left waiting
+    while (true)
     {
+        SOCKET ClientSocket = accept(ListenSocket, NULL, NULL);
+
+        if (ClientSocket == INVALID_SOCKET)
+        {
+            int error = NetworkServices::getLastError();
+            if (!NetworkServices::wouldBlock(error))
+            {
+                printf("accept failed with error: %d\n", error);
+            }
+            return accepted;
+        }
+
+        NetworkServices::setNonBlocking(ClientSocket);
         //disable nagle on the client's socket
-        char value = 1;
-        setsockopt( ClientSocket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof( value ) );
+        NetworkServices::disableNagle(ClientSocket);
 
         // insert new client into session id table
-        sessions.insert( pair<unsigned int, SOCKET>(id, ClientSocket) );
+        ClientSession & session = sessions[id];
+        session.socket = ClientSocket;
+        session.want_write = false;
+        session.read_pending = false;
+        session.closed = false;
+        socket_ids[ClientSocket] = id;
+        poller->add(ClientSocket, false);
+
+        // hand out the token that ties the client's datagrams to this session
+        session.udp_ready = false;
+        session.udp_token = 0;
+        if (UdpSocket != INVALID_SOCKET)
+        {
+            do {
+                session.udp_token = (unsigned int)token_generator();
+            } while (session.udp_token == 0 || token_ids.find(session.udp_token) != token_ids.end());
+            token_ids[session.udp_token] = id;
+
+            Packet packet;
+            packet.packet_type = UDP_CONNECT;
+            packet.token = session.udp_token;
+            char packet_data[MAX_FRAMED_PACKET_SIZE];
+            unsigned int packet_size = packet.serializeFrame(packet_data);
+            session.send_buf.insert(session.send_buf.end(), packet_data, packet_data + packet_size);
+        }
 
-        return true;
+        id++;
+        accepted++;
     }
-
-    return false;
 }
 
-// receive incoming data
-int ServerNetwork::receiveData(unsigned int client_id, char * recvbuf)
+// drain everything the client has sent straight into its ring buffer
+void ServerNetwork::readFromClient(ClientSession & session)
 {
-    if( sessions.find(client_id) != sessions.end() )
+    session.read_pending = false;
+
+    while (true)
     {
-        SOCKET currentSocket = sessions[client_id];
-        iResult = NetworkServices::receiveMessage(currentSocket, recvbuf, MAX_PACKET_SIZE);
+        unsigned int space;
+        char * recvbuf = session.recv_frames.writePtr(space);
+
+        if (space == 0)
+        {
+            // ServerGame has to consume some frames first
+            session.read_pending = true;
+            return;
+        }
+
+        iResult = NetworkServices::receiveMessage(session.socket, recvbuf, space);
+
+        if (iResult > 0)
+        {
+            session.recv_frames.commitWrite(iResult);
+            continue;
+        }
 
         if (iResult == 0)
         {
             printf("Connection closed\n");
-            closesocket(currentSocket);
+            closeSession(session);
+        }
+        else
+        {
+            int error = NetworkServices::getLastError();
+            if (!NetworkServices::wouldBlock(error))
+            {
+                printf("recv failed with error: %d\n", error);
+                closeSession(session);
+            }
+        }
+        return;
+    }
+}
+
+// drain the shared UDP socket, routing each datagram to its session by token
+void ServerNetwork::readDatagrams()
+{
+    char datagram[UDP_MAX_DATAGRAM];
+    sockaddr_storage address;
+    socklen_t address_size;
+
+    while (true)
+    {
+        iResult = NetworkServices::receiveDatagram(UdpSocket, datagram, sizeof(datagram), &address, &address_size);
+
+        if (iResult == SOCKET_ERROR)
+        {
+            // errors like ICMP port unreachable only concern one datagram, keep draining
+            if (NetworkServices::wouldBlock(NetworkServices::getLastError()))
+            {
+                return;
+            }
+            continue;
+        }
+        if (iResult <= UDP_TOKEN_SIZE + UDP_SEQUENCE_SIZE)
+        {
+            continue;
         }
 
-        return iResult;
+        unsigned int token = 0;
+        for (unsigned int i = 0; i < UDP_TOKEN_SIZE; i++)
+        {
+            token |= (unsigned int)(unsigned char)datagram[i] << (8 * i);
+        }
+        std::map<unsigned int, unsigned int>::iterator id_iter = token_ids.find(token);
+        if (id_iter == token_ids.end())
+        {
+            continue;
+        }
+        ClientSession & session = sessions[id_iter->second];
+        if (session.closed)
+        {
+            continue;
+        }
+
+        // late datagrams are dropped, only the newest state matters
+        unsigned short sequence = (unsigned short)((unsigned char)datagram[UDP_TOKEN_SIZE] | ((unsigned char)datagram[UDP_TOKEN_SIZE + 1] << 8));
+        if (!session.udp.accept(sequence))
+        {
+            continue;
+        }
+
+        // answer to wherever the client's datagrams come from (follows NAT rebinding)
+        session.udp_address = address;
+        session.udp_address_size = address_size;
+        session.udp_ready = true;
+
+        // keep the payload as a frame, dropped if ServerGame has fallen that far behind
+        unsigned int payload_size = iResult - UDP_TOKEN_SIZE - UDP_SEQUENCE_SIZE;
+        session.datagram_frames.pushFrame(datagram + UDP_TOKEN_SIZE + UDP_SEQUENCE_SIZE, payload_size);
     }
+}
+
+// write as much of the queue as the socket takes, the rest goes out when it becomes writable
+void ServerNetwork::writeToClient(ClientSession & session)
+{
+    size_t sent = 0;
 
-    return 0;
+    while (sent < session.send_buf.size())
+    {
+        iResult = NetworkServices::sendMessage(session.socket, &session.send_buf[sent], (int)(session.send_buf.size() - sent));
+
+        if (iResult == SOCKET_ERROR)
+        {
+            int error = NetworkServices::getLastError();
+            if (NetworkServices::wouldBlock(error))
+            {
+                break;
+            }
+            printf("send failed with error: %d\n", error);
+            closeSession(session);
+            return;
+        }
+        sent += iResult;
+        bytes_sent += iResult;
+    }
+
+    session.send_buf.erase(session.send_buf.begin(), session.send_buf.begin() + sent);
+
+    // only ask for writability while something is stuck in the queue
+    bool want_write = !session.send_buf.empty();
+    if (want_write != session.want_write)
+    {
+        session.want_write = want_write;
+        poller->modify(session.socket, want_write);
+    }
 }
 
-// send data to all clients
+void ServerNetwork::closeSession(ClientSession & session)
+{
+    poller->remove(session.socket);
+    socket_ids.erase(session.socket);
+    NetworkServices::closeSocket(session.socket);
+    session.send_buf.clear();
+    session.read_pending = false;
+    session.closed = true;
+}
+
+// queue data for all clients
 void ServerNetwork::sendToAll(char * packets, int totalSize)
 {
-    SOCKET currentSocket;
-    std::map<unsigned int, SOCKET>::iterator iter;
-    int iSendResult;
+    std::map<unsigned int, ClientSession>::iterator iter;
 
     for (iter = sessions.begin(); iter != sessions.end(); iter++)
     {
-        currentSocket = iter->second;
-        iSendResult = NetworkServices::sendMessage(currentSocket, packets, totalSize);
+        if (!iter->second.closed)
+        {
+            iter->second.send_buf.insert(iter->second.send_buf.end(), packets, packets + totalSize);
+        }
+    }
+}
+
+// queue data for a single client
+void ServerNetwork::sendToClient(unsigned int client_id, char * packets, int totalSize)
+{
+    std::map<unsigned int, ClientSession>::iterator iter = sessions.find(client_id);
+    if (iter == sessions.end() || iter->second.closed)
+    {
+        return;
+    }
+
+    iter->second.send_buf.insert(iter->second.send_buf.end(), packets, packets + totalSize);
+}
+
+// one send per client for everything queued this tick
+void ServerNetwork::flush()
+{
+    std::map<unsigned int, ClientSession>::iterator iter;
 
-        if (iSendResult == SOCKET_ERROR) 
+    for (iter = sessions.begin(); iter != sessions.end(); iter++)
+    {
+        // a client that is still backed up gets the rest when the poller says it is writable
+        if (!iter->second.closed && !iter->second.want_write && !iter->second.send_buf.empty())
         {
-            printf("send failed with error: %d\n", WSAGetLastError());
-            closesocket(currentSocket);
+            writeToClient(iter->second);
         }
     }
 }
+
+void ServerNetwork::sendUnreliable(unsigned int client_id, char * frame, int frameSize)
+{
+    std::map<unsigned int, ClientSession>::iterator iter = sessions.find(client_id);
+    if (iter == sessions.end() || iter->second.closed)
+    {
+        return;
+    }
+    ClientSession & session = iter->second;
+
+    int payload_size = frameSize - FRAME_HEADER_SIZE;
+    if (!session.udp_ready || payload_size > UDP_MAX_PAYLOAD)
+    {
+        sendToClient(client_id, frame, frameSize);
+        return;
+    }
+
+    char datagram[UDP_SEQUENCE_SIZE + UDP_MAX_PAYLOAD];
+    unsigned short sequence = session.udp.nextSequence();
+    datagram[0] = (char)(sequence & 0xFF);
+    datagram[1] = (char)(sequence >> 8);
+    memcpy(datagram + UDP_SEQUENCE_SIZE, frame + FRAME_HEADER_SIZE, payload_size);
+
+    iResult = NetworkServices::sendDatagram(UdpSocket, datagram, UDP_SEQUENCE_SIZE + payload_size,
+                                            (sockaddr *)&session.udp_address, session.udp_address_size);
+    if (iResult > 0)
+    {
+        bytes_sent += iResult;
+    }
+}
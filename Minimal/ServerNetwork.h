@@ -1,41 +1,94 @@
 #pragma once
-#include <winsock2.h>
-#include <Windows.h>
 #include "NetworkServices.h"
-#include <ws2tcpip.h>
+#include "NetworkPoller.h"
 #include <map>
+#include <vector>
+#include <random>
 #include "NetworkData.h"
+#include "FrameBuffer.h"
 using namespace std; 
-#pragma comment (lib, "Ws2_32.lib")
 
 #define DEFAULT_BUFLEN 512
 #define DEFAULT_PORT "6881" 
 
+// Readiness events handled per poll
+#define MAX_EVENTS_PER_POLL 64
+
+// A connected client and its buffered traffic
+struct ClientSession
+{
+    SOCKET socket;
+    FrameBuffer recv_frames;        // bytes read from the socket, consumed frame by frame by ServerGame
+    std::vector<char> send_buf;     // packets queued this tick, written in one batch by flush()
+    bool want_write;                // socket was full, waiting for it to become writable
+    bool read_pending;              // stopped reading because recv_frames was full, resume on the next poll
+    bool closed;                    // peer went away, removed on the next poll
+
+    // Optional UDP path, usable once a datagram carrying udp_token has arrived
+    unsigned int udp_token;
+    bool udp_ready;
+    sockaddr_storage udp_address;   // where the client's datagrams come from
+    socklen_t udp_address_size;
+    SequencedChannel udp;
+    FrameBuffer datagram_frames;    // payloads of accepted datagrams, consumed like recv_frames
+};
+
 class ServerNetwork
 {
 public:
     ServerNetwork(void);
     ~ServerNetwork(void);
 
-	// send data to all clients
+    /* Single readiness loop: accept every pending client and drain every readable session
+     * id - id to give the next accepted client, incremented per client
+     * timeout_ms - how long to wait for activity (0 to return immediately)
+     * returns the number of clients accepted
+     */
+    unsigned int poll(unsigned int & id, int timeout_ms);
+
+	// queue data for all clients
     void sendToAll(char * packets, int totalSize);
 
-	// receive incoming data
-    int receiveData(unsigned int client_id, char * recvbuf);
-	
-	// accept new connections
-    bool acceptNewClient(unsigned int & id);
+	// queue data for a single client
+	void sendToClient(unsigned int client_id, char * packets, int totalSize);
+
+    // write out everything queued since the last flush
+    void flush();
+
+    /* Send a frame on the unreliable sequenced channel
+     * Goes out as a UDP datagram right away if the client has opened its UDP path, otherwise it is queued on TCP
+     */
+    void sendUnreliable(unsigned int client_id, char * frame, int frameSize);
 
     // Socket to listen for new connections
     SOCKET ListenSocket;
 
-    // Socket to give to the clients
-    SOCKET ClientSocket;
+    // Socket for every client's datagrams (same port as ListenSocket)
+    SOCKET UdpSocket;
 
     // for error checking return values
     int iResult;
 
-    // table to keep track of each client's socket
-    std::map<unsigned int, SOCKET> sessions; 
-};
+    // bytes written to client sockets since startup
+    unsigned long long bytes_sent;
+
+    // table to keep track of each client's session
+    std::map<unsigned int, ClientSession> sessions; 
+
+private:
+    NetworkPoller * poller;
+
+    // session id of each client socket, to map readiness events back to sessions
+    std::map<SOCKET, unsigned int> socket_ids;
 
+    // session id of each UDP token
+    std::map<unsigned int, unsigned int> token_ids;
+    std::mt19937 token_generator;
+
+    void readDatagrams();
+
+    unsigned int acceptNewClients(unsigned int & id);
+    void readFromClient(ClientSession & session);
+    void writeToClient(ClientSession & session);
+    void closeSession(ClientSession & session);
+};
@@ -21,13 +21,37 @@
 #include <iostream>
 #include <stdio.h>
 #include <vector>
+#include <map>
+#include <memory>
 #include <algorithm>
+
+#include "FrameUniforms.h"
+#include "GLState.h"
 using namespace std;
 
+// Uniforms set on every draw, looked up by index instead of by name
+enum ShaderUniform {
+	UNIFORM_MODEL,				// mat4 model
+	UNIFORM_COLLISION_COLOR,	// vec3 collision_color (bounds.frag)
+	UNIFORM_SKYBOX,				// samplerCube skybox (skybox.frag)
+	UNIFORM_WHICH_PLAYER,		// int which_player (player.frag)
+	NUM_SHADER_UNIFORMS
+};
+
+// Uniform locations of a linked program
+struct ShaderUniforms {
+	GLint known[NUM_SHADER_UNIFORMS];		// By ShaderUniform, -1 if the program doesn't use it
+	std::map<std::string, GLint> locations;	// Every active uniform by name (arrays by their plain name too)
+
+	ShaderUniforms() { std::fill(known, known + NUM_SHADER_UNIFORMS, -1); }
+};
+
 class Shader
 {
 public:
 	unsigned int ID;
+	// Filled once at link time. Shared, so passing a Shader around doesn't copy the table
+	std::shared_ptr<ShaderUniforms> uniforms = std::make_shared<ShaderUniforms>();
 	// constructor generates the shader on the fly
 	// ------------------------------------------------------------------------
 	Shader(const char * vertex_file_path, const char * fragment_file_path) {
@@ -135,6 +159,7 @@ public:
 		glDeleteShader(FragmentShaderID);
 
 		ID = ProgramID;
+		reflectUniforms();
 	}
 	/*
 	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
@@ -231,70 +256,127 @@ public:
 
 	// activate the shader
 	// ------------------------------------------------------------------------
-	void use()
+	void use() const
+	{
+		glState().useProgram(ID);
+	}
+	// uniform locations (from the table built at link time, no GL query)
+	// ------------------------------------------------------------------------
+	GLint location(ShaderUniform uniform) const
+	{
+		return uniforms->known[uniform];
+	}
+	GLint location(const std::string &name) const
+	{
+		std::map<std::string, GLint>::const_iterator it = uniforms->locations.find(name);
+		return it == uniforms->locations.end() ? -1 : it->second;
+	}
+	void setMat4(ShaderUniform uniform, const glm::mat4 &mat) const
+	{
+		glUniformMatrix4fv(location(uniform), 1, GL_FALSE, &mat[0][0]);
+	}
+	void setVec3(ShaderUniform uniform, float x, float y, float z) const
 	{
-		glUseProgram(ID);
+		glUniform3f(location(uniform), x, y, z);
+	}
+	void setInt(ShaderUniform uniform, int value) const
+	{
+		glUniform1i(location(uniform), value);
 	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(location(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(location(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(location(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform2fv(location(name), 1, &value[0]);
 	}
 	void setVec2(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		glUniform2f(location(name), x, y);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform3fv(location(name), 1, &value[0]);
 	}
 	void setVec3(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(location(name), x, y, z);
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform4fv(location(name), 1, &value[0]);
 	}
 	void setVec4(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		glUniform4f(location(name), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	// looks up every active uniform once after linking and points the Frame block at the shared buffer
+	// ------------------------------------------------------------------------
+	void reflectUniforms()
+	{
+		static const char * known_names[NUM_SHADER_UNIFORMS] = { "model", "collision_color", "skybox", "which_player" };
+
+		GLint count = 0, max_length = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+		std::vector<char> name(max_length + 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLint size;
+			GLenum type;
+			GLsizei length = 0;
+			glGetActiveUniform(ID, i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+			std::string uniform(&name[0], length);
+			// Members of uniform blocks have no location
+			GLint uniform_location = glGetUniformLocation(ID, uniform.c_str());
+			if (uniform_location < 0)
+				continue;
+			uniforms->locations[uniform] = uniform_location;
+			// Arrays are reported as "name[0]", which "name" also refers to
+			size_t bracket = uniform.find('[');
+			if (bracket != std::string::npos)
+				uniforms->locations[uniform.substr(0, bracket)] = uniform_location;
+		}
+		for (unsigned int i = 0; i < NUM_SHADER_UNIFORMS; i++)
+			uniforms->known[i] = location(known_names[i]);
+
+		GLuint frame_block = glGetUniformBlockIndex(ID, FRAME_UNIFORM_BLOCK);
+		if (frame_block != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, frame_block, FRAME_UNIFORM_BINDING);
+	}
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
@@ -41,6 +41,10 @@ Skybox::~Skybox()
 	glDeleteBuffers(1, &VBO);
 	glDeleteBuffers(1, &EBO);
 	glDeleteTextures(1, &textureID);
+	glState().deletedVertexArray(VAO);
+	glState().deletedBuffer(VBO);
+	glState().deletedBuffer(EBO);
+	glState().deletedTexture(textureID);
 }
 
 void Skybox::initialize() {
@@ -50,10 +54,10 @@ void Skybox::initialize() {
 	glGenBuffers(1, &EBO);
 
 	// Bind the Vertex Array Object (VAO) first, then bind the associated buffers to it.
-	glBindVertexArray(VAO);
+	glState().bindVertexArray(VAO);
 
 	// Now bind a VBO to it as a GL_ARRAY_BUFFER. 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
 	// glBufferData populates the most recently bound buffer with data starting at the 3rd argument and ending after
 	// the 2nd argument number of indices. How does OpenGL know how long an index spans? Go to glVertexAttribPointer.
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_sky), &vertices_sky, GL_STATIC_DRAW);
@@ -62,45 +66,30 @@ void Skybox::initialize() {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
 
 	// In what order should it draw those vertices_sky? That's why we'll need a GL_ELEMENT_ARRAY_BUFFER for this.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices_sky), indices_sky, GL_STATIC_DRAW);
 
 	// Unbind the currently bound buffer so that we don't accidentally make unwanted changes to it.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glState().bindBuffer(GL_ARRAY_BUFFER, 0);
 	// Unbind the VAO now so we don't accidentally tamper with it.
-	glBindVertexArray(0);
+	glState().bindVertexArray(0);
 }
 
-void Skybox::draw(GLuint shaderProgram, const glm::mat4 projection, glm::mat4 modelview_) {
+void Skybox::draw(const RenderContext & context) {
+	const Shader & shader = *context.shader;
 	glDepthFunc(GL_LEQUAL);
 	glDepthMask(GL_FALSE);
 
-	// Calculate the combination of the model and view (camera inverse) matrices
-	glm::mat4 modelview = modelview_ * toWorld;
-
-	// Make skybox seem infinitely far away
-	for (int i = 0; i < 3; i++) { modelview[3][i] = 0; }
-
-	uProjection = glGetUniformLocation(shaderProgram, "projection");
-	uModelview = glGetUniformLocation(shaderProgram, "modelview");
-
-	// Now send these values to the shader program
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &projection[0][0]);
-	glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
+	// The shader drops the translation of view * model to make the skybox seem infinitely far away
+	shader.setMat4(UNIFORM_MODEL, toWorld);
 
 	// Draw skybox
-	glBindVertexArray(VAO);
-	glActiveTexture(GL_TEXTURE0);
-	glUniform1i(glGetUniformLocation(shaderProgram, "skybox"), 0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glState().bindVertexArray(VAO);
+	shader.setInt(UNIFORM_SKYBOX, 0);
+	glState().bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
 	// Tell OpenGL to draw with triangles, using 36 indices, the type of the indices, and the offset to start from
-	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-
-	// Unbind the VAO when we're done so we don't accidentally draw extra stuff or tamper with its bound buffers
-	glBindVertexArray(0);
-	// Unbind skybox texture
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, stereoInstances(1));
 
 	glDepthMask(GL_TRUE);
 	glDepthFunc(GL_LESS);
@@ -174,7 +163,7 @@ void Skybox::loadTextures() {
 	glGenTextures(1, &textureID);
 
 	// Set this texture to be the one we are working with
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glState().bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
 	// Some lighting/filtering settings
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);	// Don't let bytes be padded
@@ -208,5 +197,5 @@ void Skybox::loadTextures() {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glState().bindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
 }
\ No newline at end of file
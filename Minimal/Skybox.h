@@ -23,6 +23,9 @@
 #include <iostream>
 #include <vector>
 
+#include "RenderContext.h"
+#include "Stereo.h"
+
 // Default skybox face paths (CHANGE)
 #define SKY_PATH_UP "../assets/Skybox_Water222_top.ppm"
 #define SKY_PATH_DOWN "../assets/Skybox_Water222_base.ppm"
@@ -43,7 +46,6 @@ private:
 
 	// These variables are needed for the shader program
 	GLuint VBO, VAO, EBO;
-	GLuint uProjection, uModelview;
 	GLuint textureID;
 
 	/* Helper functions to initialize the skybox */
@@ -57,11 +59,9 @@ public:
 	~Skybox();
 
 	/* Skybox render function
-	 * shaderProgram - glsl shader ID
-	 * projection - projection matrix
-	 * modelview - modelview matrix
+	 * context - render state of the pass (skybox shader, reads the projection and view from the Frame block)
 	 */
-	void draw(GLuint shaderProgram, const glm::mat4 projection, glm::mat4 modelview);
+	void draw(const RenderContext & context);
 };
 
 // Define the coordinates and indices needed to draw the cube. Note that it is not necessary
@@ -0,0 +1,306 @@
+#include "Snapshot.h"
+#include "NetworkData.h"
+
+// Delta flags
+#define DELTA_HAS_BASELINE	(1 << 0)
+#define DELTA_HP			(1 << 1)
+#define DELTA_SCORE			(1 << 2)
+
+// Enemy speeds are sent as unsigned 8.8 fixed point
+#define ENTITY_SPEED_SCALE 256.0f
+
+/*------------------------ BYTE HELPERS ---------------------------*/
+static void writeU8(std::vector<char> & data, unsigned int value) {
+	data.push_back((char)(value & 0xFF));
+}
+
+static void writeU16(std::vector<char> & data, unsigned int value) {
+	data.push_back((char)(value & 0xFF));
+	data.push_back((char)((value >> 8) & 0xFF));
+}
+
+static void writeU32(std::vector<char> & data, unsigned int value) {
+	writeU16(data, value & 0xFFFF);
+	writeU16(data, value >> 16);
+}
+
+static unsigned int speedToWire(float speed) {
+	float scaled = speed * ENTITY_SPEED_SCALE + 0.5f;
+	return scaled <= 0.0f ? 0 : (scaled >= 65535.0f ? 65535 : (unsigned int)scaled);
+}
+
+static void writeF32(std::vector<char> & data, float value) {
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeU32(data, bits);
+}
+
+// Reads bounds-checked values out of a received delta
+struct DeltaReader {
+	const char * data;
+	unsigned int length;
+	unsigned int pos;
+	bool ok;
+
+	bool has(unsigned int bytes) {
+		ok = ok && pos + bytes <= length;
+		return ok;
+	}
+	unsigned int u8() {
+		if (!has(1)) return 0;
+		return (unsigned char)data[pos++];
+	}
+	unsigned int u16() {
+		if (!has(2)) return 0;
+		unsigned int value = (unsigned char)data[pos] | ((unsigned char)data[pos + 1] << 8);
+		pos += 2;
+		return value;
+	}
+	unsigned int u32() {
+		unsigned int low = u16();
+		return low | (u16() << 16);
+	}
+	float f32() {
+		unsigned int bits = u32();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
+
+static void writePose(std::vector<char> & data, const glm::mat4 & pose) {
+	char encoded[POSE_MAX_ENCODED_SIZE];
+	unsigned int size = Packet::poseCodec().encode(pose, encoded);
+	data.insert(data.end(), encoded, encoded + size);
+}
+
+// Poses are compared after quantization, so a resent sample that only differs by float noise is not sent
+static bool samePose(const PlayerState & a, const PlayerState & b) {
+	// A newer sample is always sent so the receiver's jitter buffer keeps advancing
+	if (a.time != b.time) {
+		return false;
+	}
+
+	char encoded_a[2 * POSE_MAX_ENCODED_SIZE];
+	char encoded_b[2 * POSE_MAX_ENCODED_SIZE];
+	const PoseCodec & codec = Packet::poseCodec();
+
+	unsigned int size = codec.encode(a.hand_transform, encoded_a);
+	size += codec.encode(a.head_transform, encoded_a + size);
+	codec.encode(b.hand_transform, encoded_b);
+	codec.encode(b.head_transform, encoded_b + codec.encodedSize());
+	return memcmp(encoded_a, encoded_b, size) == 0;
+}
+
+/*------------------------ SNAPSHOT ---------------------------*/
+float EntityState::positionAt(unsigned int at) const {
+	// Receivers only have the speed in 1/256ths, so the sender extrapolates with that too
+	float wire_speed = speedToWire(speed) / ENTITY_SPEED_SCALE;
+	return position + wire_speed * (float)(int)(at - time) / 1000.0f;
+}
+
+WorldSnapshot::WorldSnapshot() {
+	sequence = SNAPSHOT_NO_ACK;
+	time = 0;
+	HP = 0;
+	score = 0;
+}
+
+void WorldSnapshot::writeDelta(const WorldSnapshot * baseline, int skip_slot, std::vector<char> & data) const {
+	unsigned int flags = 0;
+	if (baseline) flags |= DELTA_HAS_BASELINE;
+	if (!baseline || baseline->HP != HP) flags |= DELTA_HP;
+	if (!baseline || baseline->score != score) flags |= DELTA_SCORE;
+
+	writeU16(data, sequence);
+	writeU8(data, flags);
+	if (baseline) writeU16(data, baseline->sequence);
+	writeU32(data, time);
+	if (flags & DELTA_HP) writeU16(data, (unsigned short)HP);
+	if (flags & DELTA_SCORE) writeU16(data, score);
+
+	static const std::vector<PlayerState> no_players;
+	static const std::vector<EntityState> no_entities;
+	const std::vector<PlayerState> & old_players = baseline ? baseline->players : no_players;
+	const std::vector<EntityState> & old_entities = baseline ? baseline->entities : no_entities;
+
+	// Players: merge the two slot-sorted lists
+	std::vector<const PlayerState *> changed_players;
+	std::vector<unsigned int> removed_players;
+	unsigned int i = 0, j = 0;
+	while (i < players.size() || j < old_players.size()) {
+		if (j == old_players.size() || (i < players.size() && players[i].slot < old_players[j].slot)) {
+			if (players[i].slot != skip_slot) changed_players.push_back(&players[i]);
+			i++;
+		}
+		else if (i == players.size() || old_players[j].slot < players[i].slot) {
+			if (old_players[j].slot != skip_slot) removed_players.push_back(old_players[j].slot);
+			j++;
+		}
+		else {
+			if (players[i].slot != skip_slot && !samePose(players[i], old_players[j])) changed_players.push_back(&players[i]);
+			i++;
+			j++;
+		}
+	}
+
+	writeU8(data, (unsigned int)changed_players.size());
+	for (const PlayerState * player : changed_players) {
+		writeU8(data, player->slot);
+		writePose(data, player->hand_transform);
+		writePose(data, player->head_transform);
+		writeU32(data, player->time);
+	}
+	writeU8(data, (unsigned int)removed_players.size());
+	for (unsigned int slot : removed_players) {
+		writeU8(data, slot);
+	}
+
+	// Entities: merge the two id-sorted lists
+	std::vector<const EntityState *> changed_entities;
+	std::vector<unsigned int> removed_entities;
+	i = 0;
+	j = 0;
+	while (i < entities.size() || j < old_entities.size()) {
+		if (j == old_entities.size() || (i < entities.size() && entities[i].id < old_entities[j].id)) {
+			changed_entities.push_back(&entities[i++]);
+		}
+		else if (i == entities.size() || old_entities[j].id < entities[i].id) {
+			removed_entities.push_back(old_entities[j++].id);
+		}
+		else {
+			// Unchanged keyframes are left out, the receiver keeps extrapolating them
+			if (entities[i].path != old_entities[j].path || entities[i].type != old_entities[j].type
+				|| entities[i].speed != old_entities[j].speed || entities[i].position != old_entities[j].position
+				|| entities[i].time != old_entities[j].time) {
+				changed_entities.push_back(&entities[i]);
+			}
+			i++;
+			j++;
+		}
+	}
+
+	writeU16(data, (unsigned int)changed_entities.size());
+	for (const EntityState * entity : changed_entities) {
+		writeU16(data, entity->id);
+		writeU8(data, entity->path);
+		writeU8(data, entity->type);
+		writeU16(data, speedToWire(entity->speed));
+		writeF32(data, entity->position);
+		writeU32(data, entity->time);
+	}
+	writeU16(data, (unsigned int)removed_entities.size());
+	for (unsigned int id : removed_entities) {
+		writeU16(data, id);
+	}
+}
+
+bool WorldSnapshot::readDelta(const char * data, unsigned int length, const SnapshotHistory & history) {
+	DeltaReader reader = { data, length, 0, true };
+
+	unsigned short new_sequence = (unsigned short)reader.u16();
+	unsigned int flags = reader.u8();
+
+	// Start from the baseline (or from nothing) and apply the changes
+	WorldSnapshot result;
+	if (flags & DELTA_HAS_BASELINE) {
+		const WorldSnapshot * baseline = history.find((unsigned short)reader.u16());
+		if (!baseline) {
+			return false;
+		}
+		result = *baseline;
+	}
+	result.sequence = new_sequence;
+	result.time = reader.u32();
+	if (flags & DELTA_HP) result.HP = (short)reader.u16();
+	if (flags & DELTA_SCORE) result.score = (unsigned short)reader.u16();
+
+	const PoseCodec & codec = Packet::poseCodec();
+	unsigned int count = reader.u8();
+	for (unsigned int n = 0; n < count && reader.has(1 + 2 * codec.encodedSize() + 4); n++) {
+		PlayerState player;
+		player.slot = (unsigned char)reader.u8();
+		player.hand_transform = codec.decode(data + reader.pos);
+		player.head_transform = codec.decode(data + reader.pos + codec.encodedSize());
+		reader.pos += 2 * codec.encodedSize();
+		player.time = reader.u32();
+
+		std::vector<PlayerState>::iterator iter = result.players.begin();
+		while (iter != result.players.end() && iter->slot < player.slot) iter++;
+		if (iter != result.players.end() && iter->slot == player.slot) *iter = player;
+		else result.players.insert(iter, player);
+	}
+	count = reader.u8();
+	for (unsigned int n = 0; n < count && reader.ok; n++) {
+		unsigned int slot = reader.u8();
+		for (std::vector<PlayerState>::iterator iter = result.players.begin(); iter != result.players.end(); iter++) {
+			if (iter->slot == slot) {
+				result.players.erase(iter);
+				break;
+			}
+		}
+	}
+
+	// Changed entities arrive sorted by id, so one pass merges them in
+	count = reader.u16();
+	std::vector<EntityState> merged;
+	merged.reserve(result.entities.size() + count);
+	unsigned int old_index = 0;
+	for (unsigned int n = 0; n < count && reader.ok; n++) {
+		EntityState entity;
+		entity.id = (unsigned short)reader.u16();
+		entity.path = (unsigned char)reader.u8();
+		entity.type = (unsigned char)reader.u8();
+		entity.speed = reader.u16() / ENTITY_SPEED_SCALE;
+		entity.position = reader.f32();
+		entity.time = reader.u32();
+
+		while (old_index < result.entities.size() && result.entities[old_index].id < entity.id) {
+			merged.push_back(result.entities[old_index++]);
+		}
+		if (old_index < result.entities.size() && result.entities[old_index].id == entity.id) {
+			old_index++;
+		}
+		merged.push_back(entity);
+	}
+	merged.insert(merged.end(), result.entities.begin() + old_index, result.entities.end());
+	result.entities.swap(merged);
+
+	count = reader.u16();
+	for (unsigned int n = 0; n < count && reader.ok; n++) {
+		unsigned int id = reader.u16();
+		for (std::vector<EntityState>::iterator iter = result.entities.begin(); iter != result.entities.end(); iter++) {
+			if (iter->id == id) {
+				result.entities.erase(iter);
+				break;
+			}
+		}
+	}
+
+	if (!reader.ok || reader.pos != length) {
+		return false;
+	}
+	*this = result;
+	return true;
+}
+
+/*------------------------ HISTORY ---------------------------*/
+SnapshotHistory::SnapshotHistory() {
+	for (unsigned int i = 0; i < SNAPSHOT_HISTORY; i++) {
+		used[i] = false;
+	}
+}
+
+void SnapshotHistory::store(const WorldSnapshot & snapshot) {
+	unsigned int slot = snapshot.sequence % SNAPSHOT_HISTORY;
+	snapshots[slot] = snapshot;
+	used[slot] = true;
+}
+
+const WorldSnapshot * SnapshotHistory::find(unsigned short sequence) const {
+	unsigned int slot = sequence % SNAPSHOT_HISTORY;
+	if (!used[slot] || snapshots[slot].sequence != sequence) {
+		return NULL;
+	}
+	return &snapshots[slot];
+}
@@ -0,0 +1,84 @@
+/* World snapshots broadcast by the server, delta-compressed against the last snapshot each client acked
+ * A delta only carries what changed since the baseline: HP/score, player poses with a newer sample,
+ * and enemies that were added, re-keyed or removed. Without a usable baseline the full snapshot is sent.
+ * Enemies are sent as a keyframe (distance along the path at a server time, and speed) that receivers
+ * extrapolate from, so an enemy walking its path costs nothing until the server re-keys it: on a
+ * path/type/speed change or once the extrapolation is off by more than SNAPSHOT_ENTITY_DRIFT.
+ */
+#pragma once
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+// Snapshots kept on each end for use as baselines (power of two)
+#define SNAPSHOT_HISTORY 64
+// Sequence 0 is never used, so it means "nothing acked yet"
+#define SNAPSHOT_NO_ACK 0
+// How far (world units along the path) an enemy's extrapolated position may be off before it is sent again
+#define SNAPSHOT_ENTITY_DRIFT 0.05f
+
+struct PlayerState {
+	unsigned char slot;				// Player 1 is slot 0, player 2 is slot 1
+	glm::mat4 hand_transform;
+	glm::mat4 head_transform;
+	unsigned int time;				// Owner's clock when the pose was taken, ms (for PoseBuffer)
+};
+
+struct EntityState {
+	unsigned short id;				// Stable for the entity's lifetime
+	unsigned char path;				// Path the enemy walks
+	unsigned char type;				// Enemy type
+	float speed;					// World units per second (sent in 1/256ths)
+	float position;					// Distance along the path at time
+	unsigned int time;				// Server time of the keyframe, ms
+
+	// Distance along the path extrapolated to a server time (ms), the same on both ends
+	float positionAt(unsigned int at) const;
+};
+
+class SnapshotHistory;
+
+struct WorldSnapshot {
+	unsigned short sequence;
+	unsigned int time;						// Server time the snapshot was taken, ms
+	short HP;
+	unsigned short score;
+	std::vector<PlayerState> players;		// Sorted by slot
+	std::vector<EntityState> entities;		// Sorted by id
+
+	WorldSnapshot();
+
+	/* Append this snapshot, encoded against a baseline, to data
+	 * baseline - snapshot the receiver already has (NULL to send everything)
+	 * skip_slot - player left out entirely (the receiver's own pose), -1 for none
+	 */
+	void writeDelta(const WorldSnapshot * baseline, int skip_slot, std::vector<char> & data) const;
+
+	/* Rebuild a snapshot from a delta
+	 * history - received snapshots, the delta's baseline is looked up here
+	 * returns false if the data is malformed or the baseline is no longer available
+	 */
+	bool readDelta(const char * data, unsigned int length, const SnapshotHistory & history);
+};
+
+// Ring of the most recent snapshots, indexed by sequence
+class SnapshotHistory {
+public:
+	SnapshotHistory();
+
+	void store(const WorldSnapshot & snapshot);
+	// Snapshot with this sequence, or NULL if it was never stored or has been overwritten
+	const WorldSnapshot * find(unsigned short sequence) const;
+
+private:
+	WorldSnapshot snapshots[SNAPSHOT_HISTORY];
+	bool used[SNAPSHOT_HISTORY];
+};
+
+#endif
@@ -0,0 +1,42 @@
+/* Single-pass stereo state shared by the draw paths
+ * Both eyes sit side by side in one render target. With single-pass stereo on, every draw call is
+ * issued with twice the instances: even instances go to the left eye, odd ones to the right. The
+ * vertex shader picks that eye's matrices from the Frame block (FrameUniforms.h), squeezes the vertex
+ * into the eye's half of the target and clips it at the middle (gl_ClipDistance[0]), so the scene is
+ * submitted once per frame.
+ */
+#pragma once
+#ifndef _STEREO_H_
+#define _STEREO_H_
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#include <glm/mat4x4.hpp>
+
+#define STEREO_EYES 2
+
+struct StereoView {
+	bool enabled = false;					// Off: renderScene runs once per eye
+	glm::mat4 projection[STEREO_EYES];		// Per-eye projection (left, right)
+	glm::mat4 view[STEREO_EYES];			// Per-eye view (inverse eye pose)
+};
+
+// The frame's stereo state (RiftApp::draw fills it before rendering the scene)
+inline StereoView & stereoView() {
+	static StereoView view;
+	return view;
+}
+
+/* Instances a draw call needs so that each eye gets the given number of copies
+ * instances - copies per eye
+ */
+inline GLsizei stereoInstances(GLsizei instances) {
+	return stereoView().enabled ? instances * STEREO_EYES : instances;
+}
+
+#endif
@@ -25,8 +25,10 @@ void Transform::removeChild(Node* toDelete) {
 }
 
 /** TRANSFORMATION FUNCTIONS**/
-void Transform::draw(Shader shader, glm::mat4 P, glm::mat4 V, glm::mat4 C) {
-	for (Node* ptr : child_ptrs) { ptr->draw(shader, P, V, M * C); }
+void Transform::draw(RenderContext & context) {
+	context.transforms.push(M);
+	for (Node* ptr : child_ptrs) { ptr->draw(context); }
+	context.transforms.pop();
 }
 // Getter
 glm::mat4 Transform::get_transform() { return M; }
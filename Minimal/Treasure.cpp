@@ -28,8 +28,14 @@ void Treasure::initialize() {
 }
 
 /*------ MORE GAME RELATED FUNCTIONS ------*/
-void Treasure::draw(Shader shader, glm::mat4 P, glm::mat4 V) {
+void Treasure::addToScene(SceneGraph & scene) {
 	for (Model * parts : models) {
-		parts->draw(shader, P, V);
+		nodes.push_back(scene.add(parts->getToWorld()));
+	}
+}
+
+void Treasure::draw(const RenderContext & context, const SceneGraph & scene) {
+	for (unsigned int i = 0; i < models.size(); i++) {
+		models[i]->drawAt(context, scene.world(nodes[i]));
 	}
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 #include "Model.h"
 #include "Bound.h"
+#include "SceneGraph.h"
 
 class Treasure {
 public:
@@ -33,12 +34,21 @@ public:
 	Treasure(Model * pedestal, Model * treasure);
 	~Treasure();
 
-	void draw(Shader shader, glm::mat4 P, glm::mat4 V);		// Render function
+	/* Add the pedestal and treasure to the scene. They never move, so their world matrices are computed once
+	 * scene - scene graph holding the players and the treasure
+	 */
+	void addToScene(SceneGraph & scene);
+	/* Render function, draws the models at their cached world matrices
+	 * context - render state of the pass
+	 * scene - the scene graph the treasure was added to
+	 */
+	void draw(const RenderContext & context, const SceneGraph & scene);
 
 private:
 	/* Private Data */
 	std::vector<Model *> models;	// Will store pointers to head and hand(s)
 	Bound * attack_box;				// Contains the attack box (will it be needed?)
+	std::vector<unsigned int> nodes;	// Scene node of each model
 
 	/* Private Functions */
 	void initialize();	// Move Treasure and pedestal together correctly
@@ -0,0 +1,124 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include "WaveScheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// Longest line read from a wave file
+#define WAVE_LINE_LENGTH 256
+
+/*----------------------- CONSTRUCTORS/DESTRUCTOR --------------------------*/
+WaveScheduler::WaveScheduler() {
+	pending_count = 0;
+}
+
+/*------------------------ HELPER FUNCTIONS ---------------------------*/
+bool WaveScheduler::later(const PendingSpawn & a, const PendingSpawn & b) {
+	if (a.time != b.time) {
+		return a.time > b.time;
+	}
+	return a.group > b.group;
+}
+
+/*------------------------ PUBLIC FUNCTIONS ---------------------------*/
+bool WaveScheduler::load(const char * path) {
+	FILE * fp = fopen(path, "r");
+	if (fp == NULL) {
+		printf("Could not open wave file %s\n", path);
+		return false;
+	}
+
+	std::vector<char> text;
+	char buffer[WAVE_LINE_LENGTH];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+		text.insert(text.end(), buffer, buffer + read);
+	}
+	fclose(fp);
+	text.push_back('\0');
+
+	parse(text.data(), path);
+	return true;
+}
+
+void WaveScheduler::parse(const char * text, const char * name) {
+	wave_groups.clear();
+
+	unsigned int line_number = 0;
+	while (*text) {
+		// Copy out one line
+		char line[WAVE_LINE_LENGTH];
+		size_t length = strcspn(text, "\r\n");
+		size_t copied = length < WAVE_LINE_LENGTH - 1 ? length : WAVE_LINE_LENGTH - 1;
+		memcpy(line, text, copied);
+		line[copied] = '\0';
+		text += length;
+		text += strspn(text, "\r\n");
+		line_number++;
+
+		const char * start = line + strspn(line, " \t");
+		if (*start == '\0' || *start == '#') {
+			continue;
+		}
+
+		WaveGroup group;
+		unsigned int path, type;
+		if (sscanf(start, "%lf %u %u %u %lf %f", &group.time, &path, &type, &group.count, &group.interval, &group.speed) != 6
+			|| group.time < 0.0 || group.interval < 0.0 || group.speed <= 0.0f || path > 0xFF || type > 0xFF) {
+			printf("%s:%u: expected \"time path type count interval speed\", skipping\n", name, line_number);
+			continue;
+		}
+		group.path = (unsigned char)path;
+		group.type = (unsigned char)type;
+		if (group.count > 0) {
+			wave_groups.push_back(group);
+		}
+	}
+
+	// A group only ever has one pending spawn, so the queue never grows past this
+	queue.reserve(wave_groups.size());
+	reset();
+}
+
+void WaveScheduler::reset() {
+	queue.clear();
+	pending_count = 0;
+	for (unsigned int i = 0; i < wave_groups.size(); i++) {
+		PendingSpawn spawn = { wave_groups[i].time, i, wave_groups[i].count };
+		queue.push_back(spawn);
+		pending_count += wave_groups[i].count;
+	}
+	std::make_heap(queue.begin(), queue.end(), later);
+}
+
+unsigned int WaveScheduler::update(double match_time, EnemyPool & enemies, unsigned int num_paths) {
+	unsigned int spawned = 0;
+	while (!queue.empty() && queue.front().time <= match_time) {
+		std::pop_heap(queue.begin(), queue.end(), later);
+		PendingSpawn & due = queue.back();
+		const WaveGroup & group = wave_groups[due.group];
+
+		if (group.path < num_paths && enemies.spawn(group.path, group.speed, group.type) != ENEMY_NONE) {
+			spawned++;
+		}
+		pending_count--;
+
+		// The rest of the group goes back in line behind this one
+		if (--due.remaining > 0) {
+			due.time += group.interval;
+			std::push_heap(queue.begin(), queue.end(), later);
+		}
+		else {
+			queue.pop_back();
+		}
+	}
+	return spawned;
+}
+
+const std::vector<WaveGroup> & WaveScheduler::groups() {
+	return wave_groups;
+}
+
+unsigned int WaveScheduler::pending() {
+	return pending_count;
+}
@@ -0,0 +1,70 @@
+/* Enemy spawn schedule for a match, read from a wave file
+ * Each line of the file is one group: "time path type count interval speed" (see waves.txt). Pending spawns are
+ * kept in a min-heap on time, with at most one entry per group, so a tick only touches the spawns that are due.
+ */
+#pragma once
+#ifndef _WAVE_SCHEDULER_H_
+#define _WAVE_SCHEDULER_H_
+
+#include "EnemyPool.h"
+#include <vector>
+
+// Wave file read at startup, next to the shaders
+#define WAVE_FILE_PATH "waves.txt"
+
+// A group of enemies of one type sent down one path, one every interval seconds
+struct WaveGroup {
+	double time;					// Seconds into the match the first enemy spawns
+	unsigned char path;
+	unsigned char type;
+	unsigned int count;
+	double interval;				// Seconds between the enemies of the group
+	float speed;					// World units per second
+};
+
+class WaveScheduler {
+public:
+	WaveScheduler();
+
+	/* Read the wave groups from a file, replacing any loaded before
+	 * Lines starting with # are comments. Malformed lines are reported and skipped
+	 * returns false if the file could not be opened
+	 */
+	bool load(const char * path);
+	/* Read the wave groups from text in the wave file format
+	 * name - shown in error messages
+	 */
+	void parse(const char * text, const char * name);
+
+	// Rewind to the start of the match
+	void reset();
+
+	/* Spawn every enemy that is due
+	 * match_time - seconds since the match started
+	 * num_paths - paths that exist (groups on other paths are dropped)
+	 * returns the number spawned
+	 */
+	unsigned int update(double match_time, EnemyPool & enemies, unsigned int num_paths);
+
+	// Groups loaded from the file
+	const std::vector<WaveGroup> & groups();
+	// Enemies still to spawn this match
+	unsigned int pending();
+
+private:
+	// Next spawn of one group
+	struct PendingSpawn {
+		double time;
+		unsigned int group;
+		unsigned int remaining;		// Enemies left in the group, including this one
+	};
+
+	std::vector<WaveGroup> wave_groups;
+	std::vector<PendingSpawn> queue;	// Min-heap on time
+	unsigned int pending_count;
+
+	// Heap order: the earliest spawn on top (ties in file order)
+	static bool later(const PendingSpawn & a, const PendingSpawn & b);
+};
+
+#endif
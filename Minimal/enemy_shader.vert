@@ -4,15 +4,26 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame matrices shared by every shader (FrameUniforms.h). With single-pass stereo,
+// even instances draw the left eye and odd ones the right
+layout (std140) uniform Frame {
+    mat4 projection[2];
+    mat4 view[2];
+    int stereo;
+};
 
 out vec3 Normal;
 out vec2 TexCoords;
 
 void main()
 {
+    int eye = stereo != 0 ? gl_InstanceID % 2 : 0;
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection[eye] * view[eye] * model * vec4(aPos, 1.0);
+    if (stereo != 0) {
+        // Squeeze into this eye's half of the side-by-side target and clip at the middle (Stereo.h)
+        gl_Position.x = gl_Position.x * 0.5 + (eye == 0 ? -0.5 : 0.5) * gl_Position.w;
+        gl_ClipDistance[0] = eye == 0 ? -gl_Position.x : gl_Position.x;
+    }
 	Normal = normalize(aNormal);
 }
\ No newline at end of file
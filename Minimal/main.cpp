@@ -79,11 +79,6 @@ using glm::quat;
 #define CAT_LOW_HEALTH 7
 #define GAME_START 8
 
-// Limits
-#define GAME_TIME_LIMIT 60.0
-#define HP_LIMIT 10
-#define LOW_HEALTH_LIMIT 4
-
 #define SERVER 1
 #define CLIENT 2
 
@@ -98,11 +93,13 @@ using glm::quat;
 #include "Player.h"
 #include "Enemy.h"
 #include "Curve.h"
+#include "GameLogic.h"
 
 /* Server/Client data */
 ServerGame * server;
 ClientGame * client;
 unsigned int server_or_client = 1;						// Is the instance a server or a client?
+bool use_udp = true;									// Client streams poses over UDP (falls back to TCP)
 
 /*------------------ NETWORK FUNCTIONS -----------------*/
 void serverLoop(void * arg)
@@ -331,7 +328,7 @@ protected:
 		case GLFW_KEY_ESCAPE:
 			glfwSetWindowShouldClose(window, 1);
 			if (server_or_client == CLIENT) {
-				closesocket(client->network->ConnectSocket);
+				NetworkServices::closeSocket(client->network->ConnectSocket);
 			}
 			return;
 		}
@@ -491,6 +488,14 @@ private:
 	ovrLayerEyeFov _sceneLayer;
 	ovrViewScaleDesc _viewScaleDesc;
 
+	unsigned int _frameDrawCalls{ 0 };
+	unsigned int _frameMeshesCulled{ 0 };
+	unsigned int _frameStateChanges{ 0 };
+	unsigned int _frameSkippedGLCalls{ 0 };
+	double _frameSceneMicros{ 0.0 };
+	bool _stereoSupported{ false };
+	bool _singlePassStereo{ false };		// Both eyes in one renderScene call (see Stereo.h)
+
 	uvec2 _renderTargetSize;
 	uvec2 _mirrorSize;
 
@@ -519,6 +524,11 @@ public:
 			_renderTargetSize.y = std::max(_renderTargetSize.y, (uint32_t)eyeSize.h);
 			_renderTargetSize.x += eyeSize.w;
 		});
+		// Single-pass stereo splits the target down the middle, so it needs two equal eye viewports
+		const ovrSizei & left = _sceneLayer.Viewport[ovrEye_Left].Size;
+		const ovrSizei & right = _sceneLayer.Viewport[ovrEye_Right].Size;
+		_stereoSupported = left.w == right.w && left.h == right.h && (uint32_t)left.h == _renderTargetSize.y;
+		_singlePassStereo = _stereoSupported;
 		// Make the on screen window 1/4 the resolution of the render target
 		_mirrorSize = _renderTargetSize;
 		_mirrorSize /= 4;
@@ -558,13 +568,13 @@ protected:
 		for (int i = 0; i < length; ++i) {
 			GLuint chainTexId;
 			ovr_GetTextureSwapChainBufferGL(_session, _eyeTexture, i, &chainTexId);
-			glBindTexture(GL_TEXTURE_2D, chainTexId);
+			glState().bindTexture(0, GL_TEXTURE_2D, chainTexId);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		}
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glState().bindTexture(0, GL_TEXTURE_2D, 0);
 
 		// Set up the framebuffer object
 		glGenFramebuffers(1, &_fbo);
@@ -592,6 +602,23 @@ protected:
 		case GLFW_KEY_R:
 			ovr_RecenterTrackingOrigin(_session);
 			return;
+		case GLFW_KEY_C:
+			// Should stay flat as waves grow (one multi draw per run of meshes sharing shader and textures, see GeometryArena.h)
+			cout << "Mesh draw calls last frame: " << _frameDrawCalls << endl;
+			// Meshes (and enemy copies' meshes) outside the view, never submitted
+			cout << "Meshes culled last frame: " << _frameMeshesCulled << endl;
+			// Program and texture switches made by the render queue
+			cout << "Render state changes last frame: " << _frameStateChanges << endl;
+			// Binds and state changes dropped because GL already had that state (see GLState.h)
+			cout << "Redundant GL calls skipped last frame: " << _frameSkippedGLCalls << endl;
+			// CPU time spent walking the scene and submitting it (both eyes)
+			cout << "Scene submission last frame: " << _frameSceneMicros << " us" << endl;
+			return;
+		case GLFW_KEY_V:
+			// Switch between single-pass and one pass per eye (both should look the same)
+			_singlePassStereo = _stereoSupported && !_singlePassStereo;
+			cout << (_singlePassStereo ? "Single-pass stereo" : "One pass per eye") << endl;
+			return;
 		}
 
 		GlfwApp::onKey(key, scancode, action, mods);
@@ -608,12 +635,44 @@ protected:
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
 		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, curTexId, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		ovr::for_each_eye([&](ovrEyeType eye) {
-			const auto& vp = _sceneLayer.Viewport[eye];
-			glViewport(vp.Pos.x, vp.Pos.y, vp.Size.w, vp.Size.h);
-			_sceneLayer.RenderPose[eye] = eyePoses[eye];
-			renderScene(_eyeProjections[eye], ovr::toGlm(eyePoses[eye]));
-		});
+		meshDrawCalls() = 0;
+		meshesCulled() = 0;
+		renderStateChanges() = 0;
+		// The SDK's frame submission and mirror blit are not tracked, start the frame from a clean slate
+		glState().invalidate();
+		glState().skipped = 0;
+		std::chrono::high_resolution_clock::time_point scene_start = std::chrono::high_resolution_clock::now();
+		if (_singlePassStereo) {
+			// Every draw covers both eyes, so the scene is submitted once
+			StereoView & stereo = stereoView();
+			ovr::for_each_eye([&](ovrEyeType eye) {
+				_sceneLayer.RenderPose[eye] = eyePoses[eye];
+				stereo.projection[eye] = _eyeProjections[eye];
+				stereo.view[eye] = glm::inverse(ovr::toGlm(eyePoses[eye]));
+			});
+			stereo.enabled = true;
+			updateFrameUniforms(stereo.projection, stereo.view, STEREO_EYES);
+			glViewport(0, 0, _renderTargetSize.x, _renderTargetSize.y);
+			glEnable(GL_CLIP_DISTANCE0);
+			renderScene(_eyeProjections[ovrEye_Left], ovr::toGlm(eyePoses[ovrEye_Left]));
+			glDisable(GL_CLIP_DISTANCE0);
+			stereo.enabled = false;
+		}
+		else {
+			ovr::for_each_eye([&](ovrEyeType eye) {
+				const auto& vp = _sceneLayer.Viewport[eye];
+				glViewport(vp.Pos.x, vp.Pos.y, vp.Size.w, vp.Size.h);
+				_sceneLayer.RenderPose[eye] = eyePoses[eye];
+				mat4 view = glm::inverse(ovr::toGlm(eyePoses[eye]));
+				updateFrameUniforms(&_eyeProjections[eye], &view, 1);
+				renderScene(_eyeProjections[eye], ovr::toGlm(eyePoses[eye]));
+			});
+		}
+		_frameDrawCalls = meshDrawCalls();
+		_frameMeshesCulled = meshesCulled();
+		_frameStateChanges = renderStateChanges();
+		_frameSkippedGLCalls = glState().skipped;
+		_frameSceneMicros = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - scene_start).count();
 		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		ovr_CommitTextureSwapChain(_session, _eyeTexture);
@@ -628,6 +687,10 @@ protected:
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 	}
 
+	/* Draw the scene for one eye, or for both with single-pass stereo
+	 * projection - eye projection matrix (the left eye's with single-pass stereo, where draws take both eyes from stereoView())
+	 * headPose - eye pose (likewise)
+	 */
 	virtual void renderScene(const glm::mat4 & projection, const glm::mat4 & headPose) = 0;
 };
 
@@ -649,40 +712,33 @@ public:
 	Player * player_1, * player_2;							// Players
 	Enemy * test_enemy;										// Enemy
 
-	/* Enemy Path testers */
-	Curve * curve1, *curve2, *curve3, *curve4;				// Enemy paths
-	vector<Curve *> path_container;							// Contains pointers to enemy paths
+	/* Game simulation (enemy paths, hit detection, HP, match timer) */
+	GameLogic * logic;
 	
 	/* Shaders */
 	Shader * obj_shader, *sky_shader;						// Shaders for objects and skybox
 	Shader * treasure_shader, *player_shader;				// Shaders for the treasure and the player
 	Shader * enemy_shader, *bound_shader;					// Shader for the enemy
+	Shader * enemy_instanced_shader;						// Shader for drawing all enemies in one instanced call
 
 	/* Audio */
 	Audio * sounds;											// Holds sounds (bgm/sound fx)
 
 	/* State indicators */
 	unsigned int stage_type = 1;							// Stage to load (NOT ENOUGH TIME TO IMPLEMENT)
-	int HP = HP_LIMIT;										// HP of the cat
-	bool game_win = false;									// Game win state
-	bool game_lose = false;									// Game lose state
 	bool cat_hit = false;
 	bool play_monster_noise = false;
-	bool start_game = false;								// Start game start
-	bool start_timer = false;								// Start timer when connection established
 	bool button_down = false;								// Button press state
-	std::chrono::system_clock::time_point start_time;		// Keep track of time at each starting call
+	std::chrono::system_clock::time_point last_update_time;	// Time of the previous update call (feeds the fixed-tick accumulator)
+	unsigned short applied_snapshot = SNAPSHOT_NO_ACK;		// Last server snapshot applied to the client's game logic
+	vector<mat4> enemy_instances;							// Model matrix of each live enemy, rebuilt every eye
+	RenderContext render_context;							// Render state handed down the scene each pass
+	RenderQueue render_queue;								// Model draws of the pass, sorted by state before drawing
+	SceneGraph scene;										// Players and treasure, world matrices cached between frames
 
 	/* Position/Transformation indicators */
 	mat4 rHandTransform1, rHandTransform2;					// Right hand transformation (translation * rotation)
 	mat4 headTransform1, headTransform2;					// Head transformation matrix (translation * rotation)
-	
-	/* Path indices */
-	unsigned int path_ind1 = 0;
-	unsigned int path_ind2 = 0;
-	unsigned int path_ind3 = 0;
-	unsigned int path_ind4 = 0;
-	vector<unsigned int *> path_ind_container;
 
 
 	/** Private Functions **/
@@ -701,7 +757,12 @@ public:
 		treasure_unit = new Treasure(pedestal, treasure);	// Pedestal and treasure treated as one whole unit
 		player_1 = new Player(head, sphere, sword, true);
 		player_2 = new Player(head, sphere, sword, false);
-		test_enemy = new Enemy(str_mons, false, 1.5f);
+		test_enemy = new Enemy(str_mons, false, ENEMY_SCALE);
+		// Once the models are placed, so the scene picks up their final toWorld
+		treasure_unit->addToScene(scene);
+		player_1->addToScene(scene);
+		player_2->addToScene(scene);
+		scene.update();
 		cout << "Finished loading models!" << std::endl;
 	}
 
@@ -750,66 +811,38 @@ public:
 		sky_shader = new Shader("skybox.vert", "skybox.frag");
 		player_shader = new Shader("player.vert", "player.frag");
 		enemy_shader = new Shader("enemy_shader.vert", "enemy_shader.frag");
+		enemy_instanced_shader = new Shader("enemy_instanced.vert", "enemy_shader.frag");
 		bound_shader = new Shader("bounds.vert", "bounds.frag");
 	}
 
-	void initialize_enemy_paths() {
-		// Front path
-		vec4 p0 = vec4(0, -0.2f, -10.0f, 1.0f);
-		vec4 p1 = vec4(-7.0f, 0.9f, -2.8f, 1.0f);
-		vec4 p2 = vec4(7.0f, -0.2f, -1.4f, 1.0f);
-		vec4 p3 = vec4(0, -0.2f, 1.0f, 1.0f);
-		curve1 = new Curve(mat4(p0, p1, p2, p3), 1300);
-
-		// Back path
-		p0 = vec4( 0.0f, 8.0f, 10.0f, 1.0f);
-		p1 = vec4(7.0f, 0.9f, 7.0f, 1.0f);
-		p2 = vec4(-4.0f, 5.0f, 4.0f, 1.0f);
-		curve2 = new Curve(mat4(p0, p1, p2, p3), 800);
-
-		// Left path
-		p0 = vec4(-7.0f, 1.0f, 0.0f, 1.0f);
-		p1 = vec4(-5.5f, -1.0f, 1.0f, 1.0f);
-		p2 = vec4(-2.0f, -0.2f, 1.0f, 1.0f);
-		curve3 = new Curve(mat4(p0, p1, p2, p3), 700);
-
-		// Right path
-		p0 = vec4(9.0f, 2.0f, -3.0f, 1.0f);
-		p1 = vec4(6.4f, 0.0f, 1.0f, 1.0f);
-		p2 = vec4(4.5f, 0.0f, 1.2f, 1.0f);
-		curve4 = new Curve(mat4(p0, p1, p2, p3), 900);
-
-		// Populate containers
-		path_container.push_back(curve1);
-		path_container.push_back(curve2);
-		path_container.push_back(curve3);
-		path_container.push_back(curve4);
-		path_ind_container.push_back(&path_ind1);
-		path_ind_container.push_back(&path_ind2);
-		path_ind_container.push_back(&path_ind3);
-		path_ind_container.push_back(&path_ind4);
-
+	void initialize_game_logic() {
+		// Hitboxes are sized from the loaded sword and enemy models
+		logic = new GameLogic(player_1->getSwordBoxSize(), test_enemy->getHitBoxSize());
+		last_update_time = std::chrono::system_clock::now();
 	}
 
 	/*------------------ UPDATE FUNCTIONS -------------------*/
 	void sendDataOverNetwork() {
 		// Server version
-		if (server_or_client == SERVER && server->player2Found) {
-			vector<unsigned int> path_inds;
-			for (unsigned int i = 0; i < 4; i++) {
-				path_inds.push_back(*(path_ind_container[i]));
+		if (server_or_client == SERVER) {
+			if (server->player2Found) {
+				// Send player1 location, enemy locations, HP and score to player2
+				WorldSnapshot snapshot;
+				logic->fillSnapshot(snapshot);
+				PlayerState host = { 0, rHandTransform1, headTransform1, PoseBuffer::timestampMs() };
+				PlayerState guest = { 1, server->clientHandTransforms[server->players[0]], server->clientHeadTransforms[server->players[0]],
+									  server->clientPoseTimes[server->players[0]] };
+				snapshot.players.push_back(host);
+				snapshot.players.push_back(guest);
+				server->sendSnapshots(snapshot, 1);
 			}
-			// Send player1 location and enemy location to player2
-			server->sendPackets(rHandTransform1, headTransform1, path_inds);
+			// Everything queued this frame goes out in one write per client
+			server->flushPackets();
 		}
 		// Client version
 		else if (server_or_client == CLIENT && client->player1Found) {
 			// Send player2 location to player1
 			client->sendPackets(rHandTransform2, headTransform2);
-			// Fill up path indices
-			for (unsigned int i = 0; i < 4; i++) {
-				*(path_ind_container[i]) = client->receivedPathInds[i];
-			}
 		}
 	}
 
@@ -834,8 +867,11 @@ public:
 			headTransform1 = headPosMat * headRotMat;
 			// Update player 2 information if player 2 has been connected
 			if (server->player2Found) {
-				rHandTransform2 = server->receivedHandTransform;
-				headTransform2 = server->receivedHeadTransform;
+				// Played back through the jitter buffer so player 2 moves smoothly at the display rate
+				if (!server->sampleClientPose(server->players[0], PoseBuffer::localTime(), rHandTransform2, headTransform2)) {
+					rHandTransform2 = server->receivedHandTransform;
+					headTransform2 = server->receivedHeadTransform;
+				}
 			}
 		}
 		// Client version
@@ -844,88 +880,45 @@ public:
 			headTransform2 = headPosMat * headRotMat;
 			// Update player 1 information if player 1 has been found
 			if (client->player1Found) {
-				rHandTransform1 = client->receivedHandTransform;
-				headTransform1 = client->receivedHeadTransform;
+				// Played back through the jitter buffer so player 1 moves smoothly at the display rate
+				if (!client->remotePose.sample(PoseBuffer::localTime(), rHandTransform1, headTransform1)) {
+					rHandTransform1 = client->receivedHandTransform;
+					headTransform1 = client->receivedHeadTransform;
+				}
 			}
 		}
 	}
 	
-	void handleGameState(bool wonGame) {
-		// Did you win?
-		if (wonGame) {
-			game_win = true;
-			// Play win game sound
+	// Play the sounds for the events raised by a game logic tick
+	void handleGameEvents(unsigned int events) {
+		if (events & EVENT_GAME_START) {
+			sounds->play(GAME_START);
+		}
+		if (events & EVENT_GAME_WIN) {
 			sounds->play(GAME_WIN);
-			cout << "YOU WIN!" << endl;
 		}
-		// Did you lose?
-		else {
-			game_win = false;
-			// Play lose game sound
+		if (events & EVENT_GAME_OVER) {
 			sounds->play(GAME_OVER);
-			cout << "YOU LOSE!" << endl;
 		}
-
-		// Reset states
-		start_game = false;
-		start_time = std::chrono::system_clock::now();
-		HP = HP_LIMIT;
-		path_ind1 = 0;
-		path_ind2 = 0;
-		path_ind3 = 0;
-		path_ind4 = 0;
-	}
-
-	void handleMainGameLogic() {
-		// Update sword bounding box
-		player_1->updateBoundingBox(rHandTransform1);
-		player_2->updateBoundingBox(rHandTransform2);
-
-		if (server_or_client == CLIENT) {
-			for (unsigned int i = 0; i < 4; i++) {
-				*(path_ind_container[i]) = client->receivedPathInds[i];
-			}
+		if (events & EVENT_MONSTER_DEATH) {
+			sounds->play(MON_DEATH1);
+			play_monster_noise = true;
 		}
+		if (events & EVENT_CAT_HIT) {
+			sounds->play(CAT_HIT);
+			cat_hit = true;
+		}
+		if (events & EVENT_CAT_LOW_HEALTH) {
+			sounds->play(CAT_LOW_HEALTH);
+		}
+	}
 
-		// The server handles the main game logic
-			// Go through each path (1 monster is on each path at a time)
-			for (unsigned int i = 0; i < path_container.size(); i++) {
-				// Update monster hitbox
-				test_enemy->updateHitBox(glm::translate(path_container[i]->getVertices()[*(path_ind_container[i])]));
-				// Check if box is hit
-				if (player_1->checkHit(test_enemy->getHitBox())) {
-					*(path_ind_container[i]) = 0;
-					sounds->play(MON_DEATH1);
-					play_monster_noise = true;
-				}
-				if (player_2->checkHit(test_enemy->getHitBox())) {
-					*(path_ind_container[i]) = 0;
-					sounds->play(MON_DEATH1);
-					play_monster_noise = true;
-				}
-
-				// Update monster movement
-				else {
-					(*(path_ind_container[i]))++;
-				}
-				// Check if enemy has reached the cat
-				if (*(path_ind_container[i]) == path_container[i]->getVertices().size()) {
-					HP--;
-					sounds->play(CAT_HIT);
-					// PLAY CAT HIT bool
-					cat_hit = true;
-				}
-			}
-			// Check if low HP
-			if (HP <= LOW_HEALTH_LIMIT) {
-				sounds->play(CAT_LOW_HEALTH);
-			}
-			// Reset index
-			for (unsigned int i = 0; i < path_container.size(); i++) {
-				(*path_ind_container[i]) = *(path_ind_container[i]) % path_container[i]->getVertices().size();
-			}
-
-		
+	// Model transform of a live enemy (by pool slot), turned to face along its path
+	mat4 enemyTransform(unsigned int slot) {
+		static const float path_yaw[NUM_ENEMY_PATHS] = { 0.0f, glm::pi<float>(), glm::pi<float>() / 2, -glm::pi<float>() / 2 };
+		unsigned char path = logic->enemies.paths[slot];
+		float yaw = path < NUM_ENEMY_PATHS ? path_yaw[path] : 0.0f;
+		return glm::translate(logic->enemyPosition(slot)) * glm::rotate(yaw, vec3(0, 1, 0));
 	}
 
 
@@ -944,8 +937,8 @@ protected:
 		initialize_audio();
 		// Initialize shaders here
 		initialize_shaders();
-		// Initialize paths here
-		initialize_enemy_paths();
+		// Initialize paths and game state here
+		initialize_game_logic();
 
 		/* Pick server or client here */
 		do {
@@ -965,11 +958,11 @@ protected:
 		}
 		// initialize the client if game is client version
 		else {
-			client = new ClientGame();
+			client = new ClientGame(use_udp);
 		}
 
 		// Enable backface culling
-		glEnable(GL_CULL_FACE);
+		glState().cullFace(true);
 		
 	}
 
@@ -979,9 +972,20 @@ protected:
 		delete str_mons;
 		delete treasure_unit, player_1, player_2;
 		delete test_enemy;
+		delete logic;
 		delete stage1, stage2;
 		delete sounds;
 		delete obj_shader, sky_shader, treasure_shader, player_shader, bound_shader;
+		delete enemy_shader, enemy_instanced_shader;
+	}
+
+	void onKey(int key, int scancode, int action, int mods) override {
+		if (GLFW_PRESS == action && key == GLFW_KEY_C) {
+			// Only what moved since the last update gets recomputed
+			cout << "Scene nodes recomputed last update: " << scene.updatedLastTime() << " of " << scene.size() << endl;
+		}
+
+		RiftApp::onKey(key, scancode, action, mods);
 	}
 
 	/** Deal with idle_callbacks here **/
@@ -996,22 +1000,15 @@ protected:
 		sendDataOverNetwork();
 		// Update head and hand transformation matrices
 		updateHeadAndHandTransforms();
+		// Only the players' nodes that moved (and the models under them) are recomputed
+		player_1->updateScene(scene, rHandTransform1, headTransform1);
+		player_2->updateScene(scene, rHandTransform2, headTransform2);
+		scene.update();
 		
-		// Check if player2Found (server version)
-		if (server_or_client == SERVER && server->player2Found) {
-			if (!start_timer) {
-				cout << "Please wait 5 seconds..." << endl;
-				// Start clock
-				start_time = std::chrono::system_clock::now();
-				start_timer = true;
-			}
-		}
-		// Check if player1Found (client version)
-		else if (server_or_client == CLIENT && client->player1Found && !start_timer) {
-			cout << "Please wait 5 seconds..." << endl;
-			// Start clock
-			start_time = std::chrono::system_clock::now();
-			start_timer = true;
+		// Start the countdown once the other player has been found
+		if ((server_or_client == SERVER && server->player2Found) ||
+			(server_or_client == CLIENT && client->player1Found)) {
+			logic->startTimer();
 		}
 
 		// Play stage bgm
@@ -1022,98 +1019,102 @@ protected:
 			sounds->play(STAGE2_BGM);
 		}
 
-		
 		// Update timer
 		std::chrono::system_clock::time_point current_time = std::chrono::system_clock::now();
-		std::chrono::duration<double> elapsed_seconds = current_time - start_time;
-		// Do not go through main game logic until 5 seconds after start
-		if (!start_game) {
-			if (elapsed_seconds.count() > 5.0 && start_timer) {
-				start_game = true;
-				cout << "GAME START!" << endl;
-				// Play sound
-				sounds->play(GAME_START);
-				// Start time for actual game
-				start_time = std::chrono::system_clock::now();
-			}
-		}
-		else {
-			// Check if players won
-			if (elapsed_seconds.count() >= GAME_TIME_LIMIT) {
-				handleGameState(true);
-			}
-			// Check if players lost
-			else if (HP == 0) {
-				handleGameState(false);
-			}
-			// Continue main game updates
-			else {
-				handleMainGameLogic();
-			}
+		std::chrono::duration<double> elapsed_seconds = current_time - last_update_time;
+		last_update_time = current_time;
+
+		// The client's enemy positions, HP and score are overwritten by each new snapshot from the server
+		if (server_or_client == CLIENT && client->snapshotReceived && client->snapshot.sequence != applied_snapshot) {
+			logic->applySnapshot(client->snapshot);
+			applied_snapshot = client->snapshot.sequence;
 		}
+		// Run the game logic at its fixed tick rate, however long the frame took
+		mat4 hand_transforms[NUM_PLAYERS] = { rHandTransform1, rHandTransform2 };
+		handleGameEvents(logic->update(elapsed_seconds.count(), hand_transforms));
 	}
 
 	// RENDER MODELS HERE
 	void renderScene(const glm::mat4 & projection, const glm::mat4 & headPose) override {
-		// Skybox (Stage) Rendering
-		glFrontFace(GL_CW);	// Treat counterclockwise denotation as back face
-		sky_shader->use();
+		// Everything below reads the pass's matrices and shader from here
+		RenderContext & context = render_context;
+		context.projection = projection;
+		context.view = glm::inverse(headPose);
+		context.transforms.reset();
+		context.queue = &render_queue;
+		// One frustum around both eyes with single-pass stereo, so each object is tested once per frame
+		const StereoView & stereo = stereoView();
+		if (stereo.enabled) {
+			context.frustum = Frustum::combined(stereo.projection[0] * stereo.view[0], stereo.projection[1] * stereo.view[1]);
+		}
+		else {
+			context.frustum = Frustum(context.projection * context.view);
+		}
+
+		// Skybox (Stage) Rendering (surrounds the camera, never culled)
+		glState().frontFace(GL_CW);	// Treat counterclockwise denotation as back face
+		context.use(*sky_shader);
 		switch (stage_type) {
 		case 1:
-			stage1->draw(sky_shader->ID, projection, glm::inverse(headPose));
+			stage1->draw(context);
 			break;
 		case 2:
-			stage2->draw(sky_shader->ID, projection, glm::inverse(headPose));
+			stage2->draw(context);
 		}
 
-		// Model Rendering
-		glFrontFace(GL_CCW);	// Treat clockwise orientation as back face (default)
+		// Model Rendering (queued, drawn sorted by shader, textures and vertex array at the end)
+		glState().frontFace(GL_CCW);	// Treat clockwise orientation as back face (default)
 		// Cat rendering
-		obj_shader->use();
-		treasure_unit->draw(*obj_shader, projection, glm::inverse(headPose));
+		context.select(*obj_shader);
+		treasure_unit->draw(context, scene);
 		// Player rendering
-		player_shader->use();
+		context.select(*player_shader);
 		if (server_or_client == SERVER) {
-			player_1->drawPlayer(*player_shader, projection, glm::inverse(headPose), rHandTransform1, headTransform1);
+			player_1->drawPlayer(context, scene);
 			if (server->player2Found) {
-				player_2->drawPlayer(*player_shader, projection, glm::inverse(headPose), rHandTransform2, headTransform2);
+				player_2->drawPlayer(context, scene);
 			}
 		}
 		else if (server_or_client == CLIENT) {
-			player_2->drawPlayer(*player_shader, projection, glm::inverse(headPose), rHandTransform2, headTransform2);
+			player_2->drawPlayer(context, scene);
 			if (client->player1Found) {
-				player_1->drawPlayer(*player_shader, projection, glm::inverse(headPose), rHandTransform1, headTransform1);
+				player_1->drawPlayer(context, scene);
 			}
 		}
 
 		// Render enemies when game properly starts
-		if (start_game) {
+		if (logic->start_game) {
+			vector<Curve *> & paths = logic->path_container;
 			/**/
-			// Enemy rendering
-			enemy_shader->use();
-			test_enemy->draw(*enemy_shader, projection, glm::inverse(headPose), glm::translate(curve1->getVertices()[path_ind1]));
-			test_enemy->draw(*enemy_shader, projection, glm::inverse(headPose), glm::translate(curve2->getVertices()[path_ind2]) * glm::rotate(glm::pi<float>(), vec3(0, 1, 0)));
-			test_enemy->draw(*enemy_shader, projection, glm::inverse(headPose), glm::translate(curve3->getVertices()[path_ind3]) * glm::rotate(glm::pi<float>() / 2, vec3(0, 1, 0)));
-			test_enemy->draw(*enemy_shader, projection, glm::inverse(headPose), glm::translate(curve4->getVertices()[path_ind4]) * glm::rotate(-glm::pi<float>() / 2, vec3(0, 1, 0)));
+			// Enemy rendering (one instanced draw per mesh, however many enemies are alive)
+			enemy_instances.clear();
+			for (unsigned int slot : logic->enemies.live) {
+				enemy_instances.push_back(enemyTransform(slot));
+			}
+			context.select(*enemy_instanced_shader);
+			test_enemy->drawInstanced(context, enemy_instances);
 
 			/* DEAL WITH DEBUG CODE HERE 
 			// Path rendering
-			curve1->draw(enemy_shader->ID, projection, glm::inverse(headPose));
-			curve2->draw(enemy_shader->ID, projection, glm::inverse(headPose));
-			curve3->draw(enemy_shader->ID, projection, glm::inverse(headPose));
-			curve4->draw(enemy_shader->ID, projection, glm::inverse(headPose));
+			context.use(*enemy_shader);
+			for (Curve * path : paths) {
+				path->draw(context);
+			}
 			
 			// Bounding box rendering
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-			bound_shader->use();
-			player_1->drawBoundingBox(*bound_shader, projection, glm::inverse(headPose), rHandTransform1);
-			test_enemy->drawHitBox(*bound_shader, projection, glm::inverse(headPose), glm::translate(curve1->getVertices()[path_ind1]));
-			test_enemy->drawHitBox(*bound_shader, projection, glm::inverse(headPose), glm::translate(curve2->getVertices()[path_ind2]) * glm::rotate(glm::pi<float>(), vec3(0, 1, 0)));
-			test_enemy->drawHitBox(*bound_shader, projection, glm::inverse(headPose), glm::translate(curve3->getVertices()[path_ind3]) * glm::rotate(glm::pi<float>() / 2, vec3(0, 1, 0)));
-			test_enemy->drawHitBox(*bound_shader, projection, glm::inverse(headPose), glm::translate(curve4->getVertices()[path_ind4]) * glm::rotate(-glm::pi<float>() / 2, vec3(0, 1, 0)));
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			glState().polygonMode(GL_LINE);
+			context.use(*bound_shader);
+			player_1->drawBoundingBox(context, rHandTransform1);
+			for (unsigned int slot : logic->enemies.live) {
+				context.transforms.push(enemyTransform(slot));
+				test_enemy->drawHitBox(context);
+				context.transforms.pop();
+			}
+			glState().polygonMode(GL_FILL);
 			*/
 		}
+
+		render_queue.submit();
 	}
 };
 
@@ -4,8 +4,14 @@
 layout (location = 0) in vec3 position;
 
 // Uniform variables can be updated by fetching their location and passing values to that location
-uniform mat4 projection;
-uniform mat4 modelview;
+uniform mat4 model;
+// Per-frame matrices shared by every shader (FrameUniforms.h). With single-pass stereo,
+// even instances draw the left eye and odd ones the right
+layout (std140) uniform Frame {
+    mat4 projection[2];
+    mat4 view[2];
+    int stereo;
+};
 
 // Outputs of the vertex shader are the inputs of the same name of the fragment shader.
 out vec3 texPos;
@@ -13,6 +19,15 @@ out vec3 texPos;
 void main()
 {
     // OpenGL maintains the D matrix so you only need to multiply by P, V (aka C inverse), and M
-    gl_Position = projection * modelview * vec4(position.x, position.y, position.z, 1.0);
+    int eye = stereo != 0 ? gl_InstanceID % 2 : 0;
+    // Make skybox seem infinitely far away
+    mat4 modelview = view[eye] * model;
+    modelview[3].xyz = vec3(0.0);
+    gl_Position = projection[eye] * modelview * vec4(position.x, position.y, position.z, 1.0);
+    if (stereo != 0) {
+        // Squeeze into this eye's half of the side-by-side target and clip at the middle (Stereo.h)
+        gl_Position.x = gl_Position.x * 0.5 + (eye == 0 ? -0.5 : 0.5) * gl_Position.w;
+        gl_ClipDistance[0] = eye == 0 ? -gl_Position.x : gl_Position.x;
+    }
 	texPos = position;
 }
\ No newline at end of file